@@ -0,0 +1,246 @@
+#pragma once
+
+//
+// Bump allocator shared by the containers
+// Memory comes from chunks. An allocation bumps a cursor through the current chunk, and a new chunk is allocated
+// (twice the size of the last one, up to arenaMaxChunkSize) once it no longer fits. Nothing is freed individually,
+// resetArena() rewinds the whole arena at once for the next workload.
+// Containers take an optional arena_allocator*. When it is nullptr allocate() and deallocate() fall through to
+// malloc() and free(), so a container behaves exactly as it did before arenas.
+//
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#include "../types.h"
+
+const u64 arenaDefaultChunkSize = 1 << 20;
+const u64 arenaMaxChunkSize = 64 << 20;
+const u64 arenaDefaultAlignment = 16;
+const u64 hugePageSize = 2 << 20;
+
+struct arena_chunk {
+  arena_chunk* prev;
+  u64 size; // including this header
+  bool pages; // from allocatePages() rather than malloc()
+};
+
+struct arena_allocator {
+  u8* cursor;
+  u8* end;
+  arena_chunk* chunks; // most recent first
+  u64 nextChunkSize;
+  u64 totalMemoryAllocated;
+  bool hugePages;
+};
+
+// Size allocatePages() actually maps for a request of size bytes
+u64 pageAllocationSize(u64 size, bool hugePages) {
+#ifdef _WIN32
+  if(hugePages && GetLargePageMinimum() != 0) {
+    const u64 largePageSize = GetLargePageMinimum();
+    return (size + largePageSize - 1) / largePageSize * largePageSize;
+  }
+  return size;
+#else
+  return hugePages ? (size + hugePageSize - 1) / hugePageSize * hugePageSize : size;
+#endif
+}
+
+// Page granular allocation straight from the OS. With hugePages it tries for 2MB pages: MAP_HUGETLB, which needs pages
+// reserved in /proc/sys/vm/nr_hugepages, falling back to transparent huge pages through madvise(MADV_HUGEPAGE). On
+// Windows it tries MEM_LARGE_PAGES, which needs SeLockMemoryPrivilege, falling back to regular pages.
+// size is rounded up to a whole number of pages. Returns nullptr on failure.
+void* allocatePages(u64& size, bool hugePages) {
+#ifdef _WIN32
+  if(hugePages) {
+    if(GetLargePageMinimum() != 0) {
+      const u64 largePagesSize = pageAllocationSize(size, true);
+      void* pages = VirtualAlloc(nullptr, largePagesSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+      if(pages != nullptr) {
+        size = largePagesSize;
+        return pages;
+      }
+    }
+  }
+  return VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+  if(hugePages) {
+    size = pageAllocationSize(size, true);
+#ifdef MAP_HUGETLB
+    void* pages = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if(pages != MAP_FAILED) {
+      return pages;
+    }
+#endif
+  }
+  void* pages = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if(pages == MAP_FAILED) {
+    return nullptr;
+  }
+#ifdef MADV_HUGEPAGE
+  if(hugePages) {
+    madvise(pages, size, MADV_HUGEPAGE);
+  }
+#endif
+  return pages;
+#endif
+}
+
+void freePages(void* pages, u64 size) {
+#ifdef _WIN32
+  VirtualFree(pages, 0, MEM_RELEASE);
+#else
+  munmap(pages, size);
+#endif
+}
+
+void initArena(arena_allocator& arena, u64 chunkSize = arenaDefaultChunkSize, bool hugePages = false) {
+  arena = {};
+  arena.nextChunkSize = MAX(chunkSize, sizeof(arena_chunk) + arenaDefaultAlignment);
+  arena.hugePages = hugePages;
+}
+
+void pushChunk(arena_allocator& arena, u64 minSize) {
+  u64 chunkSize = MAX(arena.nextChunkSize, minSize + sizeof(arena_chunk));
+  arena_chunk* chunk = nullptr;
+  bool pages = false;
+  if(arena.hugePages) {
+    chunk = (arena_chunk*)allocatePages(chunkSize, true);
+    pages = (chunk != nullptr);
+  }
+  if(chunk == nullptr) {
+    chunk = (arena_chunk*)malloc(chunkSize);
+  }
+
+  chunk->prev = arena.chunks;
+  chunk->size = chunkSize;
+  chunk->pages = pages;
+  arena.chunks = chunk;
+  arena.cursor = (u8*)(chunk + 1);
+  arena.end = (u8*)chunk + chunkSize;
+  arena.totalMemoryAllocated += chunkSize;
+  arena.nextChunkSize = MIN(arena.nextChunkSize * 2, arenaMaxChunkSize);
+}
+
+void freeChunk(arena_allocator& arena, arena_chunk* chunk) {
+  arena.totalMemoryAllocated -= chunk->size;
+  if(chunk->pages) {
+    freePages(chunk, chunk->size);
+  } else {
+    free(chunk);
+  }
+}
+
+void popChunk(arena_allocator& arena) {
+  arena_chunk* chunk = arena.chunks;
+  arena.chunks = chunk->prev;
+  freeChunk(arena, chunk);
+}
+
+// alignment must be a power of two. With a nullptr arena it may not exceed what malloc() guarantees.
+void* allocate(arena_allocator* arena, u64 size, u64 alignment = arenaDefaultAlignment) {
+  if(arena == nullptr) {
+    Assert(alignment <= alignof(max_align_t));
+    return malloc(size);
+  }
+
+  u8* alignedCursor = (u8*)(((uintptr_t)arena->cursor + (alignment - 1)) & ~(uintptr_t)(alignment - 1));
+  if(arena->chunks == nullptr || alignedCursor + size > arena->end) {
+    pushChunk(*arena, size + alignment);
+    alignedCursor = (u8*)(((uintptr_t)arena->cursor + (alignment - 1)) & ~(uintptr_t)(alignment - 1));
+  }
+  arena->cursor = alignedCursor + size;
+  return alignedCursor;
+}
+
+// Only returns memory with a nullptr arena, arena memory lives until resetArena() or freeArena()
+void deallocate(arena_allocator* arena, void* ptr) {
+  if(arena == nullptr) {
+    free(ptr);
+  }
+}
+
+// Grows or shrinks an allocation, keeping the first MIN(oldSize, newSize) bytes. With a nullptr arena this is
+// realloc(), which for big blocks can remap pages instead of copying. In an arena the most recent allocation grows in
+// place when its chunk has room, anything else is copied to a new allocation.
+void* reallocate(arena_allocator* arena, void* ptr, u64 oldSize, u64 newSize, u64 alignment = arenaDefaultAlignment) {
+  if(arena == nullptr) {
+    Assert(alignment <= alignof(max_align_t));
+    return realloc(ptr, newSize);
+  }
+
+  if(ptr != nullptr && (u8*)ptr + oldSize == arena->cursor && (u8*)ptr + newSize <= arena->end) {
+    arena->cursor = (u8*)ptr + newSize;
+    return ptr;
+  }
+  void* newPtr = allocate(arena, newSize, alignment);
+  if(ptr != nullptr) {
+    memcpy(newPtr, ptr, MIN(oldSize, newSize));
+  }
+  return newPtr;
+}
+
+// For big tables that want huge pages without an arena of their own. An arena takes precedence, then hugePages maps
+// the memory with allocatePages(), otherwise it falls through to malloc(). Free with the same size and hugePages.
+// Mapped memory is page aligned and already zeroed.
+void* allocateLarge(arena_allocator* arena, u64 size, bool hugePages) {
+  if(arena == nullptr && hugePages) {
+    return allocatePages(size, true);
+  }
+  return allocate(arena, size);
+}
+
+void deallocateLarge(arena_allocator* arena, void* ptr, u64 size, bool hugePages) {
+  if(arena == nullptr && hugePages) {
+    freePages(ptr, pageAllocationSize(size, true));
+  } else {
+    deallocate(arena, ptr);
+  }
+}
+
+// Invalidates everything allocated from the arena. The largest chunk is kept for the next workload, which is usually
+// the most recent one, but not when an allocation bigger than nextChunkSize got a chunk of its own earlier on.
+void resetArena(arena_allocator& arena) {
+  arena_chunk* keptChunk = arena.chunks;
+  if(keptChunk == nullptr) {
+    return;
+  }
+  for(arena_chunk* chunk = arena.chunks->prev; chunk != nullptr; chunk = chunk->prev) {
+    if(chunk->size > keptChunk->size) {
+      keptChunk = chunk;
+    }
+  }
+
+  while(arena.chunks != nullptr) {
+    arena_chunk* chunk = arena.chunks;
+    arena.chunks = chunk->prev;
+    if(chunk != keptChunk) {
+      freeChunk(arena, chunk);
+    }
+  }
+  keptChunk->prev = nullptr;
+  arena.chunks = keptChunk;
+  arena.cursor = (u8*)(arena.chunks + 1);
+  arena.end = (u8*)arena.chunks + arena.chunks->size;
+}
+
+void freeArena(arena_allocator& arena) {
+  while(arena.chunks != nullptr) {
+    popChunk(arena);
+  }
+  arena = {};
+}
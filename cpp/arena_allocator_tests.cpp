@@ -0,0 +1,187 @@
+#include "test.h"
+
+#include "hash_func_defines.h"
+#include "arena_allocator.h"
+#include "linked_list.cpp"
+#include "hash_map_void.cpp"
+#include "hash_map_template.cpp"
+#include "bloom_filter.cpp"
+#include "dictionary_trie.cpp"
+
+TEST(ArenaAllocator, alignmentAndChunkGrowth) {
+  arena_allocator arena;
+  initArena(arena, 4096);
+
+  std::vector<u8*> allocations;
+  std::vector<u64> allocationSizes;
+  for(u32 i = 0; i < 1000; i++) {
+    const u64 alignment = 1ull << (i % 7); // 1 to 64
+    const u64 size = 1 + (i * 37) % 300;
+    u8* allocation = (u8*)allocate(&arena, size, alignment);
+    ASSERT_EQ((uintptr_t)allocation % alignment, 0);
+    memset(allocation, (u8)i, size);
+    allocations.push_back(allocation);
+    allocationSizes.push_back(size);
+  }
+
+  // nothing was overwritten by a later allocation
+  for(u32 i = 0; i < allocations.size(); i++) {
+    for(u64 j = 0; j < allocationSizes[i]; j++) {
+      ASSERT_EQ(allocations[i][j], (u8)i);
+    }
+  }
+
+  u32 chunkCount = 0;
+  u64 chunkMemory = 0;
+  u64 prevChunkSize = U64_MAX;
+  for(arena_chunk* chunk = arena.chunks; chunk != nullptr; chunk = chunk->prev) {
+    ASSERT_LE(chunk->size, prevChunkSize); // most recent chunks are the biggest
+    prevChunkSize = chunk->size;
+    chunkMemory += chunk->size;
+    chunkCount++;
+  }
+  ASSERT_GT(chunkCount, 1);
+  ASSERT_EQ(chunkMemory, arena.totalMemoryAllocated);
+
+  // bigger than any chunk so far
+  u8* bigAllocation = (u8*)allocate(&arena, arenaMaxChunkSize + 1);
+  memset(bigAllocation, 0, arenaMaxChunkSize + 1);
+
+  freeArena(arena);
+  ASSERT_EQ(arena.chunks, nullptr);
+  ASSERT_EQ(arena.totalMemoryAllocated, 0);
+}
+
+TEST(ArenaAllocator, reset) {
+  arena_allocator arena;
+  initArena(arena, 4096);
+  for(u32 i = 0; i < 100; i++) {
+    allocate(&arena, 1000);
+  }
+  const arena_chunk* lastChunk = arena.chunks;
+  const u64 lastChunkSize = lastChunk->size;
+  ASSERT_GT(arena.totalMemoryAllocated, lastChunkSize);
+
+  resetArena(arena);
+  ASSERT_EQ(arena.chunks, lastChunk);
+  ASSERT_EQ(arena.chunks->prev, nullptr);
+  ASSERT_EQ(arena.totalMemoryAllocated, lastChunkSize);
+  u8* allocation = (u8*)allocate(&arena, 1000);
+  ASSERT_EQ(allocation, (u8*)(((uintptr_t)(lastChunk + 1) + arenaDefaultAlignment - 1) & ~(uintptr_t)(arenaDefaultAlignment - 1)));
+
+  freeArena(arena);
+}
+
+TEST(ArenaAllocator, resetKeepsLargestChunk) {
+  arena_allocator arena;
+  initArena(arena, 4096);
+  allocate(&arena, 1000);
+  allocate(&arena, 100000); // its own chunk, bigger than the ones after it
+  const arena_chunk* largestChunk = arena.chunks;
+  const u64 largestChunkSize = largestChunk->size;
+  for(u32 i = 0; i < 20; i++) {
+    allocate(&arena, 1000);
+  }
+  ASSERT_NE(arena.chunks, largestChunk);
+  ASSERT_LT(arena.chunks->size, largestChunkSize);
+
+  resetArena(arena);
+  ASSERT_EQ(arena.chunks, largestChunk);
+  ASSERT_EQ(arena.chunks->prev, nullptr);
+  ASSERT_EQ(arena.totalMemoryAllocated, largestChunkSize);
+
+  freeArena(arena);
+}
+
+TEST(ArenaAllocator, nullArenaUsesMalloc) {
+  void* allocation = allocate(nullptr, 64);
+  ASSERT_NE(allocation, nullptr);
+  memset(allocation, 0, 64);
+  deallocate(nullptr, allocation);
+}
+
+TEST(ArenaAllocator, hugePages) {
+  arena_allocator arena;
+  initArena(arena, hugePageSize, true);
+  u8* allocation = (u8*)allocate(&arena, hugePageSize / 2);
+  memset(allocation, 1, hugePageSize / 2);
+  ASSERT_TRUE(arena.chunks->pages); // huge or not, the chunk came straight from the OS
+  ASSERT_EQ(arena.chunks->size % hugePageSize, 0);
+  freeArena(arena);
+}
+
+HASH_FUNC_HASH(arena_test_u64_hash) {
+  return *(u64*)key * 0x9e3779b97f4a7c15ull;
+}
+
+HASH_FUNC_EQUALS(arena_test_u64_equals) {
+  return *(u64*)key1 == *(u64*)key2;
+}
+
+u64 arenaTestTemplateHash(const u64& key) {
+  return key * 0x9e3779b97f4a7c15ull;
+}
+
+bool arenaTestTemplateEquals(const u64& key1, const u64& key2) {
+  return key1 == key2;
+}
+
+// Builds one of each container, checks them, then frees them. With an arena the frees are left to resetArena().
+void runRequestWorkload(const std::vector<char>& fileCharacters, arena_allocator* arena) {
+  linked_trie_dictionary linkedTrieDictionary;
+  buildDictionary(fileCharacters, linkedTrieDictionary, arena);
+  optimizeLayout(linkedTrieDictionary);
+  trie_dictionary trieDictionary;
+  buildDictionary(fileCharacters, trieDictionary, arena);
+  ASSERT_TRUE(contains(linkedTrieDictionary, "selected"));
+  ASSERT_TRUE(contains(trieDictionary, "selected"));
+  ASSERT_FALSE(contains(trieDictionary, "selectedz"));
+
+  singly_linked_list list = SinglyLinkedList(4, arena);
+  for(u32 i = 0; i < 1000; i++) {
+    addBack(list, i);
+  }
+  ASSERT_TRUE(contains(list, 999));
+
+  HashMapVoid hashMapVoid(sizeof(u64), sizeof(u64), arena_test_u64_hash, arena_test_u64_equals, 16, arena);
+  HashMapTemplate<u64, u64> hashMapTemplate(arenaTestTemplateHash, arenaTestTemplateEquals, 1024, arena);
+  for(u64 i = 0; i < 1000; i++) {
+    hashMapVoid.insert(&i, &i);
+    hashMapTemplate.insert(i, i);
+  }
+  u64 retrieved;
+  ASSERT_TRUE(hashMapVoid.retrieve(&list.tail->data, &retrieved));
+  ASSERT_TRUE(hashMapTemplate.contains(500));
+
+  destroy(list);
+  freeDictionary(trieDictionary);
+  freeDictionary(linkedTrieDictionary);
+}
+
+TEST(ArenaAllocator, requestScopedContainers) {
+  const u32 requestCount = 20;
+  std::vector<char> fileCharacters;
+  readFile("4000-most-common-english-words.txt", fileCharacters);
+
+  Timer timer;
+  StartTimer(timer);
+  for(u32 i = 0; i < requestCount; i++) {
+    runRequestWorkload(fileCharacters, nullptr);
+  }
+  f64 timeWithMalloc = StopTimer(timer);
+  printf("Time for %u requests (malloc): %5.5f ms\n", requestCount, timeWithMalloc);
+
+  arena_allocator arena;
+  initArena(arena);
+  StartTimer(timer);
+  for(u32 i = 0; i < requestCount; i++) {
+    runRequestWorkload(fileCharacters, &arena);
+    resetArena(arena);
+  }
+  f64 timeWithArena = StopTimer(timer);
+  printf("Time for %u requests (arena): %5.5f ms\n", requestCount, timeWithArena);
+  printf("Total Memory (arena): %5.5f MBs\n", arena.totalMemoryAllocated / 1024.0 / 1024.0);
+  ASSERT_EQ(arena.chunks->prev, nullptr);
+
+  freeArena(arena);
+}
@@ -0,0 +1,135 @@
+//
+// Approximate membership filter for byte string keys
+// A blocked Bloom filter. Every key's bits land in a single 64 byte block, so a lookup costs at most one cache miss
+// no matter how many hash functions are used. The price is a higher false positive rate than a classic Bloom filter
+// of the same size, which initBloomFilter() makes up for with extra bits per key.
+//
+
+#include <math.h>
+
+const u32 bloomFilterBlockBitCount = 512; // one cache line
+const u32 bloomFilterMaxHashCount = 16;
+
+struct bloom_filter {
+  u64* blocks; // blockCount * 8 u64s, cache line aligned
+  u64 blockCount;
+  u32 hashCount;
+  u64 keyCount;
+  void* mallocPtr;
+  u64 totalMemoryAllocated;
+};
+
+// FNV-1a followed by the murmur3 finalizer to spread the little entropy short keys have over all 64 bits
+u64 bloomFilterHash(const char* key, u64 keyByteCount) {
+  u64 hash = 0xcbf29ce484222325ull;
+  for(u64 i = 0; i < keyByteCount; i++) {
+    hash = (hash ^ (u8)key[i]) * 0x100000001b3ull;
+  }
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdull;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ull;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+// Expected false positive rate of a blocked filter. Unlike a classic filter, its keys don't spread evenly over all the
+// bits, the number of keys sharing a block is Poisson distributed and overloaded blocks give most false positives.
+f64 blockedBloomFalsePositiveRate(f64 bitsPerKey, u32 hashCount) {
+  const f64 meanKeysPerBlock = bloomFilterBlockBitCount / bitsPerKey;
+  const f64 bitStaysZero = 1.0 - 1.0 / bloomFilterBlockBitCount;
+  const u32 maxKeysPerBlock = (u32)(meanKeysPerBlock * 4) + 64;
+  f64 keysInBlockProbability = exp(-meanKeysPerBlock);
+  f64 falsePositiveRate = 0.0;
+  for(u32 keysInBlock = 0; keysInBlock < maxKeysPerBlock; keysInBlock++) {
+    falsePositiveRate += keysInBlockProbability * pow(1.0 - pow(bitStaysZero, (f64)hashCount * keysInBlock), hashCount);
+    keysInBlockProbability *= meanKeysPerBlock / (keysInBlock + 1);
+  }
+  return falsePositiveRate;
+}
+
+// Sized for expectedKeyCount keys at falsePositiveRate, a rate in (0, 1)
+void initBloomFilter(bloom_filter& filter, u64 expectedKeyCount, f64 falsePositiveRate) {
+  Assert(falsePositiveRate > 0.0 && falsePositiveRate < 1.0);
+  filter = {};
+
+  // start from what a classic Bloom filter would need and add bits until the blocked filter gets there too
+  const f64 ln2 = 0.69314718055994530942;
+  f64 bitsPerKey = MAX(-log(falsePositiveRate) / (ln2 * ln2), 1.0);
+  while(true) {
+    f64 bestFalsePositiveRate = 1.0;
+    for(u32 hashCount = 1; hashCount <= bloomFilterMaxHashCount; hashCount++) {
+      const f64 hashCountFalsePositiveRate = blockedBloomFalsePositiveRate(bitsPerKey, hashCount);
+      if(hashCountFalsePositiveRate < bestFalsePositiveRate) {
+        bestFalsePositiveRate = hashCountFalsePositiveRate;
+        filter.hashCount = hashCount;
+      }
+    }
+    if(bestFalsePositiveRate <= falsePositiveRate || filter.hashCount == bloomFilterMaxHashCount) {
+      break;
+    }
+    bitsPerKey += 0.25;
+  }
+
+  const u64 bitCount = (u64)(MAX(expectedKeyCount, 1) * bitsPerKey) + 1;
+  filter.blockCount = (bitCount + bloomFilterBlockBitCount - 1) / bloomFilterBlockBitCount;
+  Assert(filter.blockCount <= U32_MAX);
+
+  const u64 blocksMemorySize = filter.blockCount * (bloomFilterBlockBitCount / 8);
+  filter.totalMemoryAllocated = blocksMemorySize + 63;
+  filter.mallocPtr = malloc(filter.totalMemoryAllocated);
+  filter.blocks = (u64*)(((uintptr_t)filter.mallocPtr + 63) & ~(uintptr_t)63);
+  memset(filter.blocks, 0, blocksMemorySize);
+}
+
+void freeBloomFilter(bloom_filter& filter) {
+  free(filter.mallocPtr);
+  filter = {};
+}
+
+// Upper 32 bits of the hash pick the block
+u64* bloomFilterBlock(const bloom_filter& filter, u64 hash) {
+  const u64 blockIndex = ((hash >> 32) * filter.blockCount) >> 32;
+  return filter.blocks + blockIndex * (bloomFilterBlockBitCount / 64);
+}
+
+// Every bit inside the block takes its own 9 bits of hash. Double hashing (a + i * b) was tried first but mod 512 it
+// only has 512 * 256 distinct bit patterns, which put a floor of around 0.2% under the false positive rate.
+u32 nextBlockBitIndex(u64& bitHash, u32 hashIndex) {
+  if(hashIndex % 7 == 0) { // 7 bit indices per 64 bits of hash
+    bitHash = (bitHash + hashIndex) * 0x9e3779b97f4a7c15ull;
+    bitHash ^= bitHash >> 32;
+  }
+  const u32 blockBitIndex = (u32)(bitHash % bloomFilterBlockBitCount);
+  bitHash /= bloomFilterBlockBitCount;
+  return blockBitIndex;
+}
+
+void insert(bloom_filter& filter, const char* key, u64 keyByteCount) {
+  const u64 hash = bloomFilterHash(key, keyByteCount);
+  u64* block = bloomFilterBlock(filter, hash);
+  u64 bitHash = hash;
+  for(u32 i = 0; i < filter.hashCount; i++) {
+    const u32 blockBitIndex = nextBlockBitIndex(bitHash, i);
+    block[blockBitIndex / 64] |= 1ull << (blockBitIndex % 64);
+  }
+  filter.keyCount++;
+}
+
+// false means the key was definitely never inserted, true means it probably was
+bool mayContain(const bloom_filter& filter, const char* key, u64 keyByteCount) {
+  const u64 hash = bloomFilterHash(key, keyByteCount);
+  const u64* block = bloomFilterBlock(filter, hash);
+  u64 bitHash = hash;
+  for(u32 i = 0; i < filter.hashCount; i++) {
+    const u32 blockBitIndex = nextBlockBitIndex(bitHash, i);
+    if((block[blockBitIndex / 64] & (1ull << (blockBitIndex % 64))) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+f64 bitsPerKey(const bloom_filter& filter) {
+  return (f64)(filter.blockCount * bloomFilterBlockBitCount) / (f64)MAX(filter.keyCount, 1);
+}
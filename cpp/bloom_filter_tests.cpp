@@ -0,0 +1,51 @@
+#include "test.h"
+
+#include "bloom_filter.cpp"
+
+void testFalsePositiveRate(f64 falsePositiveRate, u64 keyCount) {
+  bloom_filter filter;
+  initBloomFilter(filter, keyCount, falsePositiveRate);
+
+  char key[32];
+  for(u64 i = 0; i < keyCount; i++) {
+    const int keyByteCount = snprintf(key, sizeof(key), "key%llu", (unsigned long long)i);
+    insert(filter, key, keyByteCount);
+  }
+
+  for(u64 i = 0; i < keyCount; i++) {
+    const int keyByteCount = snprintf(key, sizeof(key), "key%llu", (unsigned long long)i);
+    ASSERT_TRUE(mayContain(filter, key, keyByteCount)) << key;
+  }
+
+  u64 falsePositiveCount = 0;
+  const u64 absentKeyCount = keyCount * 4;
+  for(u64 i = 0; i < absentKeyCount; i++) {
+    const int keyByteCount = snprintf(key, sizeof(key), "absent%llu", (unsigned long long)i);
+    falsePositiveCount += mayContain(filter, key, keyByteCount);
+  }
+  const f64 measuredFalsePositiveRate = (f64)falsePositiveCount / (f64)absentKeyCount;
+  printf("False positive rate %1.5f (target %1.5f): %5.2f bits per key, %u hashes, %5.5f MBs\n",
+         measuredFalsePositiveRate, falsePositiveRate, bitsPerKey(filter), filter.hashCount,
+         filter.totalMemoryAllocated / 1024.0 / 1024.0);
+  ASSERT_LT(measuredFalsePositiveRate, falsePositiveRate * 1.5);
+
+  freeBloomFilter(filter);
+}
+
+TEST(BloomFilter, noFalseNegativesAndTargetFalsePositiveRate) {
+  testFalsePositiveRate(0.1, 100000);
+  testFalsePositiveRate(0.01, 100000);
+  testFalsePositiveRate(0.001, 100000);
+  testFalsePositiveRate(0.01, 10);
+}
+
+TEST(BloomFilter, emptyFilter) {
+  bloom_filter filter;
+  initBloomFilter(filter, 0, 0.01);
+  ASSERT_FALSE(mayContain(filter, "", 0));
+  ASSERT_FALSE(mayContain(filter, "the", 3));
+  insert(filter, "", 0);
+  ASSERT_TRUE(mayContain(filter, "", 0));
+  freeBloomFilter(filter);
+  ASSERT_EQ(filter.blocks, nullptr);
+}
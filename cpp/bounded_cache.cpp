@@ -0,0 +1,223 @@
+//
+// Bounded key-value cache with LRU or CLOCK eviction
+// Every entry carries its own hash chain link and recency links, so there's no separate eviction list to keep in sync
+// with a map: a hit is one hash lookup plus O(1) relinking. All entries come from one pool allocated up front.
+// Entries sit in a ring ordered from oldest to newest, with the clock hand at the oldest:
+//  - LRU: a hit moves the entry to the newest end, eviction takes the entry under the hand
+//  - CLOCK (second chance): a hit only sets the entry's referenced bit, eviction sweeps the hand forward clearing
+//    referenced bits until it finds an entry without one. Hits write a bit instead of relinking.
+// The cache is bounded by entry count and by total byte size, where each entry's byte size is given on insert.
+// It keeps its own table rather than wrapping HashMapTemplate: that one's remove() moves the next element of a chain
+// into the bucket's inline first element, so its elements don't stay put and recency links into them would dangle.
+//
+
+#include "arena_allocator.h"
+
+enum bounded_cache_policy : u8 {
+  BoundedCacheLRU = 0,
+  BoundedCacheClock
+};
+
+template<typename S /*key*/, typename T/*value*/>
+struct BoundedCache {
+
+  struct Entry {
+    S key;
+    T value;
+    Entry* nextInBucket;
+    Entry* newer; // ring links, the newest entry's newer is the oldest
+    Entry* older;
+    u64 byteSize;
+    bool referenced; // CLOCK only
+  };
+
+  typedef u64 hash_func_hash(const S& key);
+  typedef bool hash_func_equals(const S& key1, const S& key2);
+
+  hash_func_hash* hashFunc;
+  hash_func_equals* equalsFunc;
+  bounded_cache_policy policy;
+
+  u64 maxEntryCount;
+  u64 maxByteCount;
+  u64 entryCount;
+  u64 byteCount;
+
+  u64 hitCount;
+  u64 missCount;
+  u64 evictionCount;
+
+  Entry** buckets;
+  u64 bucketCount;
+  Entry* freeEntries; // linked through nextInBucket
+  Entry* hand; // oldest entry, nullptr when empty
+  u64 totalMallocSize;
+  void* mallocPtr;
+  arena_allocator* arena; // nullptr to malloc() and free() the entries
+
+  BoundedCache(hash_func_hash* hash, hash_func_equals* equals, u64 maxEntryCount_, u64 maxByteCount_ = U64_MAX,
+               bounded_cache_policy policy_ = BoundedCacheLRU, arena_allocator* arena_ = nullptr) {
+    hashFunc = hash;
+    equalsFunc = equals;
+    policy = policy_;
+    arena = arena_;
+    maxEntryCount = MAX(maxEntryCount_, 1);
+    maxByteCount = maxByteCount_;
+    entryCount = 0;
+    byteCount = 0;
+    hitCount = 0;
+    missCount = 0;
+    evictionCount = 0;
+
+    bucketCount = maxEntryCount;
+    u64 bucketsMallocSize = bucketCount * sizeof(Entry*);
+    u64 entriesMallocSize = maxEntryCount * sizeof(Entry);
+    totalMallocSize = bucketsMallocSize + entriesMallocSize;
+    mallocPtr = allocate(arena, totalMallocSize, alignof(Entry));
+    memset(mallocPtr, 0, totalMallocSize);
+    buckets = (Entry**)mallocPtr;
+
+    Entry* entries = (Entry*)((u8*)mallocPtr + bucketsMallocSize);
+    for(u64 i = 0; i + 1 < maxEntryCount; i++) {
+      entries[i].nextInBucket = entries + i + 1;
+    }
+    freeEntries = entries;
+    hand = nullptr;
+  }
+
+  ~BoundedCache() {
+    deallocate(arena, mallocPtr);
+  }
+
+  // the destructor frees the pool, a copy would free it twice
+  BoundedCache(const BoundedCache&) = delete;
+  BoundedCache& operator=(const BoundedCache&) = delete;
+
+  Entry** bucketOf(const S& key) {
+    return buckets + (hashFunc(key) % bucketCount);
+  }
+
+  Entry* find(const S& key) {
+    Entry* entry = *bucketOf(key);
+    while(entry != nullptr && !equalsFunc(key, entry->key)) {
+      entry = entry->nextInBucket;
+    }
+    return entry;
+  }
+
+  // Links a new entry in at the newest end of the ring
+  void linkNewest(Entry* entry) {
+    if(hand == nullptr) {
+      entry->newer = entry;
+      entry->older = entry;
+      hand = entry;
+    } else {
+      entry->newer = hand;
+      entry->older = hand->older;
+      hand->older->newer = entry;
+      hand->older = entry;
+    }
+  }
+
+  void unlink(Entry* entry) {
+    if(entry->newer == entry) { // last entry
+      hand = nullptr;
+      return;
+    }
+    if(entry == hand) {
+      hand = entry->newer;
+    }
+    entry->older->newer = entry->newer;
+    entry->newer->older = entry->older;
+  }
+
+  void touch(Entry* entry) {
+    if(policy == BoundedCacheClock) {
+      entry->referenced = true;
+    } else if(entry == hand) {
+      hand = entry->newer; // the ring is circular, the oldest becomes the newest just by moving the hand
+    } else if(entry != hand->older) {
+      unlink(entry);
+      linkNewest(entry);
+    }
+  }
+
+  void removeEntry(Entry* entry) {
+    Entry** link = bucketOf(entry->key);
+    while(*link != entry) {
+      link = &(*link)->nextInBucket;
+    }
+    *link = entry->nextInBucket;
+    unlink(entry);
+
+    entry->nextInBucket = freeEntries;
+    freeEntries = entry;
+    byteCount -= entry->byteSize;
+    --entryCount;
+  }
+
+  void evict() {
+    if(policy == BoundedCacheClock) {
+      while(hand->referenced) { // second chance
+        hand->referenced = false;
+        hand = hand->newer;
+      }
+    }
+    removeEntry(hand);
+    ++evictionCount;
+  }
+
+  // Counts a hit or a miss. A hit refreshes the entry for the eviction policy.
+  bool retrieve(const S& key, T& outValue) {
+    Entry* entry = find(key);
+    if(entry == nullptr) {
+      ++missCount;
+      return false;
+    }
+    ++hitCount;
+    touch(entry);
+    outValue = entry->value;
+    return true;
+  }
+
+  // Neither counted nor a refresh of the entry
+  bool contains(const S& key) {
+    return find(key) != nullptr;
+  }
+
+  // Inserts or replaces the value for key as the newest entry, evicting entries until both limits hold. Returns false,
+  // and caches nothing, when byteSize alone is over the byte limit.
+  bool insert(const S& key, const T& value, u64 byteSize = sizeof(T)) {
+    remove(key);
+    if(byteSize > maxByteCount) {
+      return false;
+    }
+
+    while(entryCount == maxEntryCount || byteCount + byteSize > maxByteCount) {
+      evict();
+    }
+
+    Entry* entry = freeEntries;
+    freeEntries = entry->nextInBucket;
+    entry->key = key;
+    entry->value = value;
+    entry->byteSize = byteSize;
+    entry->referenced = false;
+    Entry** bucket = bucketOf(key);
+    entry->nextInBucket = *bucket;
+    *bucket = entry;
+    linkNewest(entry);
+    byteCount += byteSize;
+    ++entryCount;
+    return true;
+  }
+
+  bool remove(const S& key) {
+    Entry* entry = find(key);
+    if(entry == nullptr) {
+      return false;
+    }
+    removeEntry(entry);
+    return true;
+  }
+};
@@ -0,0 +1,182 @@
+#include "test.h"
+#include <random>
+
+#include "linked_list.cpp"
+#include "hash_map_template.cpp"
+#include "bounded_cache.cpp"
+
+u64 cacheTestHash(const u64& key) {
+  return key * 0x9e3779b97f4a7c15ull;
+}
+
+bool cacheTestEquals(const u64& key1, const u64& key2) {
+  return key1 == key2;
+}
+
+typedef BoundedCache<u64, u64> u64_cache;
+
+// Keys from the oldest entry to the newest
+std::vector<u64> cacheKeysOldestFirst(const u64_cache& cache) {
+  std::vector<u64> keys;
+  const u64_cache::Entry* entry = cache.hand;
+  for(u64 i = 0; i < cache.entryCount; i++) {
+    EXPECT_EQ(entry->newer->older, entry);
+    keys.push_back(entry->key);
+    entry = entry->newer;
+  }
+  EXPECT_EQ(entry, cache.hand);
+  return keys;
+}
+
+TEST(BoundedCache, lru) {
+  u64_cache cache(cacheTestHash, cacheTestEquals, 3);
+  u64 value;
+  cache.insert(1, 10);
+  cache.insert(2, 20);
+  cache.insert(3, 30);
+  ASSERT_TRUE(cache.retrieve(1, value)); // 1 becomes the most recently used
+  ASSERT_EQ(value, 10);
+  cache.insert(4, 40);
+  ASSERT_FALSE(cache.contains(2));
+  ASSERT_EQ(cacheKeysOldestFirst(cache), std::vector<u64>({3, 1, 4}));
+
+  ASSERT_TRUE(cache.retrieve(4, value)); // already the newest
+  ASSERT_TRUE(cache.retrieve(3, value)); // the oldest
+  ASSERT_EQ(cacheKeysOldestFirst(cache), std::vector<u64>({1, 4, 3}));
+  cache.insert(1, 11); // replacing makes it the newest
+  ASSERT_EQ(cacheKeysOldestFirst(cache), std::vector<u64>({4, 3, 1}));
+  ASSERT_TRUE(cache.retrieve(1, value));
+  ASSERT_EQ(value, 11);
+  ASSERT_FALSE(cache.retrieve(2, value));
+
+  ASSERT_EQ(cache.hitCount, 4);
+  ASSERT_EQ(cache.missCount, 1);
+  ASSERT_EQ(cache.evictionCount, 1);
+  ASSERT_EQ(cache.entryCount, 3);
+
+  ASSERT_TRUE(cache.remove(4));
+  ASSERT_FALSE(cache.remove(4));
+  ASSERT_TRUE(cache.remove(3));
+  ASSERT_TRUE(cache.remove(1));
+  ASSERT_EQ(cache.hand, nullptr);
+  cache.insert(5, 50);
+  ASSERT_EQ(cacheKeysOldestFirst(cache), std::vector<u64>({5}));
+}
+
+TEST(BoundedCache, clockSecondChance) {
+  u64_cache cache(cacheTestHash, cacheTestEquals, 3, U64_MAX, BoundedCacheClock);
+  u64 value;
+  cache.insert(1, 10);
+  cache.insert(2, 20);
+  cache.insert(3, 30);
+  ASSERT_TRUE(cache.retrieve(1, value));
+  ASSERT_EQ(cacheKeysOldestFirst(cache), std::vector<u64>({1, 2, 3})); // hits don't relink
+
+  cache.insert(4, 40); // 1 was referenced, it gets a second chance and 2 goes
+  ASSERT_TRUE(cache.contains(1));
+  ASSERT_FALSE(cache.contains(2));
+  cache.insert(5, 50); // the hand moved on past 1, to 3
+  ASSERT_TRUE(cache.contains(1));
+  ASSERT_FALSE(cache.contains(3));
+  ASSERT_EQ(cacheKeysOldestFirst(cache), std::vector<u64>({1, 4, 5}));
+  ASSERT_EQ(cache.evictionCount, 2);
+
+  ASSERT_TRUE(cache.retrieve(1, value));
+  ASSERT_TRUE(cache.retrieve(4, value));
+  ASSERT_TRUE(cache.retrieve(5, value));
+  cache.insert(6, 60); // everything referenced, the hand comes all the way around
+  ASSERT_FALSE(cache.contains(1));
+  ASSERT_EQ(cache.entryCount, 3);
+}
+
+TEST(BoundedCache, byteLimit) {
+  u64_cache cache(cacheTestHash, cacheTestEquals, 100, 1000);
+  cache.insert(1, 10, 400);
+  cache.insert(2, 20, 400);
+  ASSERT_EQ(cache.byteCount, 800);
+  cache.insert(3, 30, 300); // evicts 1
+  ASSERT_FALSE(cache.contains(1));
+  ASSERT_EQ(cache.byteCount, 700);
+  cache.insert(3, 31, 700); // growing an entry evicts others, never itself
+  ASSERT_FALSE(cache.contains(2));
+  ASSERT_TRUE(cache.contains(3));
+  ASSERT_EQ(cache.byteCount, 700);
+  ASSERT_FALSE(cache.insert(4, 40, 1001)); // never fits
+  ASSERT_FALSE(cache.contains(4));
+  ASSERT_EQ(cache.evictionCount, 2);
+  ASSERT_EQ(cache.entryCount, 1);
+}
+
+// The hand built cache this replaces: a map from key to a node of a separate recency list holding the key
+struct hand_built_lru {
+  HashMapTemplate<u64, noop_node_d*> map;
+  doubly_linked_list list;
+  u64 capacity;
+
+  hand_built_lru(u64 capacity_) : map(cacheTestHash, cacheTestEquals, capacity_) {
+    list = DoublyLinkedList((u32)capacity_);
+    capacity = capacity_;
+  }
+
+  ~hand_built_lru() {
+    destroy(list);
+  }
+
+  bool access(u64 key) {
+    noop_node_d* node;
+    if(map.retrieve(key, node)) {
+      moveToFront(list, node);
+      return true;
+    }
+    if(list.count == capacity) {
+      u32 evictedKey = 0;
+      popBack(list, evictedKey); // never empty here, the list holds capacity entries
+      map.remove(evictedKey);
+    }
+    map.insert(key, addFront(list, (u32)key));
+    return false;
+  }
+};
+
+TEST(BoundedCache, performanceAgainstHandBuiltLru) {
+  const u64 capacity = 1 << 16;
+  const u32 accessCount = 4000000;
+  // skewed keys, most accesses go to a hot set smaller than the cache
+  std::mt19937 randomGenerator(46);
+  std::vector<u64> accesses(accessCount);
+  for(u64& access : accesses) {
+    access = (randomGenerator() % 4 != 0) ? randomGenerator() % (capacity / 2) : randomGenerator() % (capacity * 8);
+  }
+
+  hand_built_lru handBuilt(capacity);
+  u64 handBuiltHitCount = 0;
+  Timer timer;
+  StartTimer(timer);
+  for(u64 key : accesses) {
+    handBuiltHitCount += handBuilt.access(key);
+  }
+  f64 timeForHandBuilt = StopTimer(timer);
+  printf("Time for %u accesses (HashMapTemplate + doubly_linked_list): %5.5f ms, %5.2f%% hits\n", accessCount,
+         timeForHandBuilt, 100.0 * handBuiltHitCount / accessCount);
+
+  const bounded_cache_policy policies[] = {BoundedCacheLRU, BoundedCacheClock};
+  const char* policyNames[] = {"LRU", "CLOCK"};
+  for(u32 i = 0; i < ArrayCount(policies); i++) {
+    u64_cache cache(cacheTestHash, cacheTestEquals, capacity, U64_MAX, policies[i]);
+    StartTimer(timer);
+    for(u64 key : accesses) {
+      u64 value;
+      if(!cache.retrieve(key, value)) {
+        cache.insert(key, key);
+      }
+    }
+    f64 timeForCache = StopTimer(timer);
+    printf("Time for %u accesses (BoundedCache %s): %5.5f ms, %5.2f%% hits\n", accessCount, policyNames[i],
+           timeForCache, 100.0 * cache.hitCount / accessCount);
+    ASSERT_EQ(cache.hitCount + cache.missCount, accessCount);
+    ASSERT_EQ(cache.evictionCount, cache.missCount - capacity);
+    if(policies[i] == BoundedCacheLRU) {
+      ASSERT_EQ(cache.hitCount, handBuiltHitCount);
+    }
+  }
+}
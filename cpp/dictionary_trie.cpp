@@ -2,9 +2,28 @@
 // Created by Connor on 3/4/2022.
 //
 
+#include <atomic>
+#include <mutex>
+#include <queue>
+#include <string_view>
+#include <thread>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include <emmintrin.h>
+
+#include "arena_allocator.h"
+
+// TODO: handle uppercase
+bool isWordCharacter(char c) {
+  return (c >= 'a' && c <= 'z') || c == '-';
+}
+
 struct linked_trie_dictionary_node {
   char character;
   bool endOfWord;
+  u16 frequency; // see loadWordFrequencies()
+  u16 maxFrequency; // max frequency of any word ending in this node's subtree
   linked_trie_dictionary_node* firstChild;
   linked_trie_dictionary_node* nextSibling;
 };
@@ -12,9 +31,13 @@ struct linked_trie_dictionary_node {
 struct linked_trie_dictionary_allocator {
   linked_trie_dictionary_node* freeNodes;
   u32 remainingNodes;
+  linked_trie_dictionary_node* recycledNodes; // pruned by removeWord(), linked through nextSibling
   std::vector<void*> mallocPtrs;
   u32 nodeCountPerMalloc;
   u64 totalMemoryAllocated;
+  arena_allocator* arena; // nullptr to malloc() and free() node blocks
+  bool hugePages; // the first, and by far largest, block is mapped with 2MB pages when there is no arena
+  u64 firstMallocSize;
 };
 
 struct linked_trie_dictionary {
@@ -22,10 +45,45 @@ struct linked_trie_dictionary {
   linked_trie_dictionary_allocator allocator;
 };
 
+// Only the first block of each node allocator can be mapped with huge pages, see allocateLarge()
+template<typename Allocator>
+void freeBlocks(Allocator& allocator) {
+  for(u64 i = 0; i < allocator.mallocPtrs.size(); i++) {
+    if(i == 0) {
+      deallocateLarge(allocator.arena, allocator.mallocPtrs[i], allocator.firstMallocSize, allocator.hugePages);
+    } else {
+      deallocate(allocator.arena, allocator.mallocPtrs[i]);
+    }
+  }
+  allocator.mallocPtrs.clear();
+}
+
+void initAllocator(linked_trie_dictionary_allocator& allocator, u64 initialNodeCountEstimate, arena_allocator* arena = nullptr,
+                   bool hugePages = false) {
+  allocator = {};
+  allocator.arena = arena;
+  allocator.hugePages = hugePages;
+  allocator.mallocPtrs.reserve(100);
+  const u64 initialMemoryAllocated = initialNodeCountEstimate * sizeof(linked_trie_dictionary_node);
+  void* initialMallocPtr = allocateLarge(arena, initialMemoryAllocated, hugePages);
+  allocator.firstMallocSize = initialMemoryAllocated;
+  allocator.mallocPtrs.push_back(initialMallocPtr);
+  allocator.freeNodes = (linked_trie_dictionary_node*)initialMallocPtr;
+  allocator.remainingNodes = initialNodeCountEstimate;
+  allocator.totalMemoryAllocated = initialMemoryAllocated;
+  allocator.nodeCountPerMalloc = MAX(initialNodeCountEstimate / 50, 64); // increase by 2% each malloc
+}
+
 linked_trie_dictionary_node* nextFree(linked_trie_dictionary_allocator& allocator) {
+  if(allocator.recycledNodes != nullptr) {
+    linked_trie_dictionary_node* node = allocator.recycledNodes;
+    allocator.recycledNodes = node->nextSibling;
+    return node;
+  }
+
   if(allocator.remainingNodes == 0) {
     const u32 newMallocSize = sizeof(linked_trie_dictionary_node) * allocator.nodeCountPerMalloc;
-    void* newMallocPtr = malloc(newMallocSize);
+    void* newMallocPtr = allocate(allocator.arena, newMallocSize, alignof(linked_trie_dictionary_node));
     allocator.mallocPtrs.push_back(newMallocPtr);
     allocator.freeNodes = (linked_trie_dictionary_node*)newMallocPtr;
     allocator.remainingNodes = allocator.nodeCountPerMalloc;
@@ -38,11 +96,10 @@ linked_trie_dictionary_node* nextFree(linked_trie_dictionary_allocator& allocato
 
 void freeDictionary(linked_trie_dictionary& dict) {
   dict.root.character = '*';
+  dict.root.maxFrequency = 0;
   dict.root.firstChild = nullptr;
   dict.root.nextSibling = nullptr;
-  for(void* mallocPtr : dict.allocator.mallocPtrs) {
-    free(mallocPtr);
-  }
+  freeBlocks(dict.allocator);
   dict.allocator = {};
 }
 
@@ -58,11 +115,6 @@ bool contains(const linked_trie_dictionary& dict, const std::string& word) {
   while(parent != nullptr && wordIndex < wordCharCount) {
     char character = word[wordIndex++];
 
-    if(parent->firstChild == nullptr) {
-      printf("A non-null termination node should not have null child. It should either contain the next letters or a null termination node.");
-      return false;
-    }
-
     linked_trie_dictionary_node* child = parent->firstChild;
     while(child != nullptr) {
       if(child->character == character) {
@@ -79,81 +131,95 @@ bool contains(const linked_trie_dictionary& dict, const std::string& word) {
   return parent->endOfWord;
 }
 
-void buildDictionary(const std::vector<char>& fileCharacters, linked_trie_dictionary& outDict) {
-  // initialize allocator
-  outDict.allocator = {};
-  outDict.allocator.mallocPtrs.reserve(100);
-  const u64 initialNodeCountEstimate = fileCharacters.size() / 4; // The average word length in the English dictionary is 4.7
-  const u64 initialMemoryAllocated = initialNodeCountEstimate * sizeof(linked_trie_dictionary_node);
-  void* initialMallocPtr = malloc(initialMemoryAllocated);
-  outDict.allocator.mallocPtrs.push_back(initialMallocPtr);
-  outDict.allocator.freeNodes = (linked_trie_dictionary_node*)initialMallocPtr;
-  outDict.allocator.remainingNodes = initialNodeCountEstimate;
-  outDict.allocator.totalMemoryAllocated = initialMemoryAllocated;
-  outDict.allocator.nodeCountPerMalloc = initialNodeCountEstimate / 50; // increase by 2% each malloc
+// Inserts the word below parent, creating any missing nodes. Returns the node of the word's last character.
+linked_trie_dictionary_node* insertWord(linked_trie_dictionary_node* parent, linked_trie_dictionary_allocator& allocator,
+                                        const char* word, u64 wordCharCount) {
+  for(u64 wordIndex = 0; wordIndex < wordCharCount; wordIndex++) {
+    const char character = word[wordIndex];
+    linked_trie_dictionary_node* child = parent->firstChild;
+
+    // search for character amongst children
+    while(child != nullptr) {
+      if(child->character == character) {
+        parent = child;
+        break;
+      }
+      child = child->nextSibling;
+    }
+
+    // if character not found, create new one
+    if(parent != child) {
+      child = nextFree(allocator);
+      child->character = character;
+      child->nextSibling = parent->firstChild;
+      parent->firstChild = child;
+      child->firstChild = nullptr;
+      child->endOfWord = false;
+      child->frequency = 0;
+      child->maxFrequency = 0;
+      parent = child;
+    }
+  }
+
+  parent->endOfWord = true;
+  return parent;
+}
+
+// With an arena, every node is allocated from it and freeDictionary() leaves them to the arena. Without one, hugePages
+// maps the initial node block with 2MB pages, see allocateLarge().
+void buildDictionary(const char* characters, u64 charactersCount, linked_trie_dictionary& outDict, arena_allocator* arena = nullptr,
+                     bool hugePages = false) {
+  const u64 initialNodeCountEstimate = charactersCount / 4; // The average word length in the English dictionary is 4.7
+  initAllocator(outDict.allocator, initialNodeCountEstimate, arena, hugePages);
 
   // initialize root
   outDict.root.character = '*';
+  outDict.root.endOfWord = false;
+  outDict.root.frequency = 0;
+  outDict.root.maxFrequency = 0;
   outDict.root.nextSibling = nullptr;
   outDict.root.firstChild = nullptr;
 
-  u32 fileCharactersCount = fileCharacters.size();
-  for(u32 fileCharacterIndex = 0; fileCharacterIndex < fileCharactersCount; fileCharacterIndex++) {
-    char fileCharacter = fileCharacters[fileCharacterIndex];
-
-    // TODO: handle uppercase
-    if((fileCharacter < 'a' || fileCharacter > 'z') && fileCharacter != '-') {
+  u64 characterIndex = 0;
+  while(characterIndex < charactersCount) {
+    if(!isWordCharacter(characters[characterIndex])) {
+      characterIndex++;
       continue;
     }
 
-    linked_trie_dictionary_node* parent = &outDict.root;
-    while(fileCharacterIndex < fileCharactersCount) {
-      fileCharacter = fileCharacters[fileCharacterIndex++];
-      if((fileCharacter < 'a' || fileCharacter > 'z') && fileCharacter != '-') {
-        break;
-      }
-
-      linked_trie_dictionary_node* child = parent->firstChild;
-
-      // search for character amongst children
-      while(child != nullptr) {
-        if(child->character == fileCharacter) {
-          parent = child;
-          break;
-        }
-        child = child->nextSibling;
-      }
-
-      // if character not found, create new one
-      if(parent != child) {
-        child = nextFree(outDict.allocator);
-        child->character = fileCharacter;
-        child->nextSibling = parent->firstChild;
-        parent->firstChild = child;
-        child->firstChild = nullptr;
-        child->endOfWord = false;
-        parent = child;
-      }
+    const u64 wordBegin = characterIndex;
+    while(characterIndex < charactersCount && isWordCharacter(characters[characterIndex])) {
+      characterIndex++;
     }
-
-    parent->endOfWord = true;
+    insertWord(&outDict.root, outDict.allocator, characters + wordBegin, characterIndex - wordBegin);
   }
 }
 
+void buildDictionary(const std::vector<char>& fileCharacters, linked_trie_dictionary& outDict, arena_allocator* arena = nullptr,
+                     bool hugePages = false) {
+  buildDictionary(fileCharacters.data(), fileCharacters.size(), outDict, arena, hugePages);
+}
+
 // ==== TRIE USING ARRAY OF POINTERS
 const u32 supportedLetterCount = 27; // a-z, -
 
 struct trie_dictionary_node {
   bool endOfWord;
+  u16 frequency; // see loadWordFrequencies()
+  u16 maxFrequency; // max frequency of any word ending in this node's subtree
   trie_dictionary_node* children[supportedLetterCount];
 };
 
 struct trie_dictionary_allocator {
   trie_dictionary_node* freeNodes;
   u64 remainingNodes;
+  trie_dictionary_node* recycledNodes; // pruned by removeWord(), linked through children[0]
   std::vector<void*> mallocPtrs;
   u32 nodeCountPerMalloc;
   u64 totalMemoryAllocated;
+  arena_allocator* arena; // nullptr to malloc() and free() node blocks
+  bool hugePages; // the first, and by far largest, block is mapped with 2MB pages when there is no arena
+  u64 firstMallocSize;
 };
 
 struct trie_dictionary {
@@ -161,10 +227,36 @@ struct trie_dictionary {
   trie_dictionary_allocator allocator;
 };
 
+void initAllocator(trie_dictionary_allocator& allocator, u64 initialNodeCountEstimate, arena_allocator* arena = nullptr,
+                   bool hugePages = false) {
+  allocator = {};
+  allocator.arena = arena;
+  allocator.hugePages = hugePages;
+  allocator.mallocPtrs.reserve(100);
+  const u64 initialMemoryAllocated = initialNodeCountEstimate * sizeof(trie_dictionary_node);
+  void* initialMallocPtr = allocateLarge(arena, initialMemoryAllocated, hugePages);
+  if(arena != nullptr || !hugePages) { // mapped pages come zeroed
+    memset(initialMallocPtr, 0, initialMemoryAllocated);
+  }
+  allocator.firstMallocSize = initialMemoryAllocated;
+  allocator.mallocPtrs.push_back(initialMallocPtr);
+  allocator.freeNodes = (trie_dictionary_node*)initialMallocPtr;
+  allocator.remainingNodes = initialNodeCountEstimate;
+  allocator.totalMemoryAllocated = initialMemoryAllocated;
+  allocator.nodeCountPerMalloc = MAX(initialNodeCountEstimate / 50, 64); // increase by 2% each malloc
+}
+
 trie_dictionary_node* nextFree(trie_dictionary_allocator& allocator) {
+  if(allocator.recycledNodes != nullptr) {
+    trie_dictionary_node* node = allocator.recycledNodes;
+    allocator.recycledNodes = node->children[0];
+    *node = {};
+    return node;
+  }
+
   if(allocator.remainingNodes == 0) {
     const u32 newMallocSize = sizeof(trie_dictionary_node) * allocator.nodeCountPerMalloc;
-    void* newMallocPtr = malloc(newMallocSize);
+    void* newMallocPtr = allocate(allocator.arena, newMallocSize, alignof(trie_dictionary_node));
     memset(newMallocPtr, 0, newMallocSize);
     allocator.mallocPtrs.push_back(newMallocPtr);
     allocator.freeNodes = (trie_dictionary_node*)newMallocPtr;
@@ -181,12 +273,10 @@ void freeDictionary(trie_dictionary& dict) {
     dict.root.children[i] = nullptr;
   }
   dict.root.endOfWord = false;
+  dict.root.maxFrequency = 0;
 
-  for(void* mallocPtr : dict.allocator.mallocPtrs) {
-    free(mallocPtr);
-  }
+  freeBlocks(dict.allocator);
   dict.allocator = {};
-  dict.allocator.mallocPtrs.clear();
 }
 
 bool contains(const trie_dictionary& dict, const std::string& word) {
@@ -211,144 +301,1965 @@ bool contains(const trie_dictionary& dict, const std::string& word) {
   return parent->endOfWord;
 }
 
-void buildDictionary(const std::vector<char>& fileCharacters, trie_dictionary& outDict) {
-  outDict.root = {};
-  outDict.allocator = {};
-  outDict.allocator.mallocPtrs.reserve(100);
-  const u64 initialNodeCountEstimate = fileCharacters.size() / 4; // The average word length in the English dictionary is 4.7
-  const u64 initialMemoryAllocated = initialNodeCountEstimate * sizeof(trie_dictionary_node);
-  void* initialMallocPtr = malloc(initialMemoryAllocated);
-  memset(initialMallocPtr, 0, initialMemoryAllocated);
-  outDict.allocator.mallocPtrs.push_back(initialMallocPtr);
-  outDict.allocator.freeNodes = (trie_dictionary_node*)initialMallocPtr;
-  outDict.allocator.remainingNodes = initialNodeCountEstimate;
-  outDict.allocator.totalMemoryAllocated = initialMemoryAllocated;
-  outDict.allocator.nodeCountPerMalloc = initialNodeCountEstimate / 50; // increase by 2% each malloc
-
-  u32 fileCharactersCount = fileCharacters.size();
-  for(u32 fileCharacterIndex = 0; fileCharacterIndex < fileCharactersCount; fileCharacterIndex++) {
-    char fileCharacter = fileCharacters[fileCharacterIndex];
+// Expects a character that passes isWordCharacter()
+u32 letterIndex(char c) {
+  return (c == '-') ? 26 : (u32)(c - 'a');
+}
 
-    // TODO: handle uppercase
-    if((fileCharacter < 'a' || fileCharacter > 'z') && fileCharacter != '-') {
-      continue;
+// Inserts the word below parent, creating any missing nodes. Returns the node of the word's last character.
+trie_dictionary_node* insertWord(trie_dictionary_node* parent, trie_dictionary_allocator& allocator,
+                                 const char* word, u64 wordCharCount) {
+  for(u64 wordIndex = 0; wordIndex < wordCharCount; wordIndex++) {
+    const u32 childIndex = letterIndex(word[wordIndex]);
+    trie_dictionary_node* child = parent->children[childIndex];
+    if(child == nullptr) {
+      child = nextFree(allocator);
+      parent->children[childIndex] = child;
     }
+    parent = child;
+  }
 
-    trie_dictionary_node* parent = &outDict.root;
-    while(fileCharacterIndex < fileCharactersCount) {
-      fileCharacter = fileCharacters[fileCharacterIndex++];
+  parent->endOfWord = true;
+  return parent;
+}
 
-      s32 letterIndex;
-      if(fileCharacter >= 'a' && fileCharacter <= 'z') {
-        letterIndex = fileCharacter - 'a';
-      } else if(fileCharacter == '-') {
-        letterIndex = 26;
-      } else {
-        break;
-      }
+// With an arena, every node is allocated from it and freeDictionary() leaves them to the arena. Without one, hugePages
+// maps the initial node block with 2MB pages, see allocateLarge().
+void buildDictionary(const char* characters, u64 charactersCount, trie_dictionary& outDict, arena_allocator* arena = nullptr,
+                     bool hugePages = false) {
+  outDict.root = {};
+  const u64 initialNodeCountEstimate = charactersCount / 4; // The average word length in the English dictionary is 4.7
+  initAllocator(outDict.allocator, initialNodeCountEstimate, arena, hugePages);
 
-      trie_dictionary_node* child = parent->children[letterIndex];
-      if(child == nullptr) {
-        child = nextFree(outDict.allocator);
-        parent->children[letterIndex] = child;
-      }
-      parent = child;
+  u64 characterIndex = 0;
+  while(characterIndex < charactersCount) {
+    if(!isWordCharacter(characters[characterIndex])) {
+      characterIndex++;
+      continue;
     }
 
-    parent->endOfWord = true;
+    const u64 wordBegin = characterIndex;
+    while(characterIndex < charactersCount && isWordCharacter(characters[characterIndex])) {
+      characterIndex++;
+    }
+    insertWord(&outDict.root, outDict.allocator, characters + wordBegin, characterIndex - wordBegin);
   }
 }
 
-// ==== FOR ALLOCATOR PERFORMANCE TESTING =====
-struct linked_trie_dictionary_no_allocator {
-  linked_trie_dictionary_node root;
-  u64 nodeCount;
+void buildDictionary(const std::vector<char>& fileCharacters, trie_dictionary& outDict, arena_allocator* arena = nullptr,
+                     bool hugePages = false) {
+  buildDictionary(fileCharacters.data(), fileCharacters.size(), outDict, arena, hugePages);
+}
+
+// ==== ADAPTIVE RADIX TRIE
+// Handles every byte value, so UTF-8 and uppercase words are stored as is. Giving every node 256 children would make
+// the array trie's already large nodes 10x larger, so nodes instead come in three sizes and grow as children are added:
+//  - node4 and node16 keep their keys right after the header, both searched with the same SSE2 compare
+//  - node256 indexes its children directly by byte
+// There is no node48: the top of an English trie is almost all nodes with 17 to 27 children, where finding the key and
+// then loading its child was measurably slower than indexing a node256 directly. The 529 node256s cost about 1 MB.
+// Runs of single-child nodes are collapsed into a prefix of up to adaptiveTriePrefixCapacity bytes stored in the node
+// below them. Where only one word goes on, a leaf holds all of its remaining bytes instead of a chain of node4s, and
+// only becomes a node4 once another word shares it. Leaves of up to 7 bytes live in their parent's child slot, see
+// inlineLeaf(). Grown-out-of nodes are recycled for the next node of the same type. Words are separated by spaces and
+// control characters.
+// Every node other than a leaf starts a cache line, which puts a node4, or the header and keys of a bigger node, on one
+// line. Leaves are packed, but never across a line.
+enum adaptive_trie_node_type : u8 {
+  AdaptiveTrieNode4 = 0,
+  AdaptiveTrieNode16,
+  AdaptiveTrieNode256,
+  AdaptiveTrieLeaf,
+  AdaptiveTrieNodeTypeCount
 };
 
-void freeDictionary(linked_trie_dictionary_no_allocator& dict) {
-  // TODO: no thanks
+const u32 adaptiveTriePrefixCapacity = 11;
+const u32 adaptiveTrieLeafPrefixCapacity = 255;
+const u32 adaptiveTrieInlineLeafCapacity = 7;
+const u64 adaptiveTrieCacheLineSize = 64;
+
+// A node matches its prefix bytes after the key byte that led to it. endOfWord refers to the end of the prefix.
+// A leaf's prefix runs on past the end of its header.
+struct adaptive_trie_node {
+  adaptive_trie_node_type type;
+  bool endOfWord;
+  u16 childCount;
+  u8 prefixLength;
+  u8 prefix[adaptiveTriePrefixCapacity];
+};
+
+struct adaptive_trie_node4 {
+  adaptive_trie_node header;
+  u8 keys[4];
+  adaptive_trie_node* children[4];
+};
+
+struct adaptive_trie_node16 {
+  adaptive_trie_node header;
+  u8 keys[16];
+  adaptive_trie_node* children[16];
+};
+
+struct adaptive_trie_node256 {
+  adaptive_trie_node header;
+  adaptive_trie_node* children[256];
+};
+
+// Leaves are sized by their prefix, see leafSize()
+const u64 adaptiveTrieNodeSizes[AdaptiveTrieNodeTypeCount] = {
+  sizeof(adaptive_trie_node4), sizeof(adaptive_trie_node16), sizeof(adaptive_trie_node256), 0
+};
+
+const u16 adaptiveTrieNodeCapacities[AdaptiveTrieNodeTypeCount] = { 4, 16, 256, 0 };
+
+const u64 adaptiveTrieChildrenOffsets[AdaptiveTrieNodeTypeCount] = {
+  offsetof(adaptive_trie_node4, children), offsetof(adaptive_trie_node16, children), offsetof(adaptive_trie_node256, children), 0
+};
+
+struct adaptive_trie_allocator {
+  char* freeBytes;
+  u64 remainingBytes;
+  std::vector<void*> mallocPtrs;
+  u64 bytesPerMalloc;
+  u64 totalMemoryAllocated;
+  adaptive_trie_node* recycledNodes[AdaptiveTrieNodeTypeCount]; // linked through their first child pointer, no leaves
+  u64 nodeCounts[AdaptiveTrieNodeTypeCount];
+};
+
+struct adaptive_trie_dictionary {
+  adaptive_trie_node* root;
+  adaptive_trie_allocator allocator;
+};
+
+bool isByteWordDelimiter(char c) {
+  return (u8)c <= ' ';
 }
 
-bool contains(const linked_trie_dictionary_no_allocator& dict, const std::string& word) {
-  if(dict.root.character != '*' || dict.root.nextSibling != nullptr) {
-    printf("Dictionary root is borked.");
-    return false;
+u32 countTrailingZeros(u32 value) {
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward(&index, value);
+  return index;
+#else
+  return __builtin_ctz(value);
+#endif
+}
+
+// node4 and node16 both keep their keys right after the header
+u8* keysOf(adaptive_trie_node* node) {
+  return ((adaptive_trie_node4*)node)->keys;
+}
+
+adaptive_trie_node** childrenOf(adaptive_trie_node* node) {
+  return (adaptive_trie_node**)((char*)node + adaptiveTrieChildrenOffsets[node->type]);
+}
+
+// A leaf of up to adaptiveTrieInlineLeafCapacity bytes is stored in its parent's child slot rather than in a node: the
+// slot's lowest bit is set, which no node address has, the next three bits hold the length and the upper seven bytes
+// the leaf's bytes. Like every leaf it ends a word. It saves a lookup the trip to a node at the end of most words.
+adaptive_trie_node* inlineLeaf(const char* bytes, u64 length) {
+  u64 leafBytes = 0;
+  memcpy(&leafBytes, bytes, length);
+  return (adaptive_trie_node*)(uintptr_t)((leafBytes << 8) | (length << 1) | 1);
+}
+
+bool isInlineLeaf(const adaptive_trie_node* child) {
+  return ((uintptr_t)child & 1) != 0;
+}
+
+u64 inlineLeafLength(const adaptive_trie_node* leaf) {
+  return ((uintptr_t)leaf >> 1) & 7;
+}
+
+// contains() reads a leaf's prefix 16 bytes at a time, so the bytes after it are padded out to a multiple of 16
+u64 leafSize(u64 prefixLength) {
+  const u64 paddedPrefixLength = (MAX(prefixLength, 1) + 15) & ~15ull;
+  return (offsetof(adaptive_trie_node, prefix) + paddedPrefixLength + 7) & ~7ull;
+}
+
+void initAllocator(adaptive_trie_allocator& allocator, u64 initialByteCountEstimate) {
+  allocator = {};
+  allocator.mallocPtrs.reserve(100);
+  void* initialMallocPtr = malloc(initialByteCountEstimate);
+  allocator.mallocPtrs.push_back(initialMallocPtr);
+  allocator.freeBytes = (char*)initialMallocPtr;
+  allocator.remainingBytes = initialByteCountEstimate;
+  allocator.totalMemoryAllocated = initialByteCountEstimate;
+  // increase by 2% each malloc, always enough for the largest node starting a cache line
+  allocator.bytesPerMalloc = MAX(initialByteCountEstimate / 50, sizeof(adaptive_trie_node256) + adaptiveTrieCacheLineSize);
+}
+
+// A leaf only moves on to the next cache line if it would straddle this one, anything else starts a line
+char* nextFreeBytes(adaptive_trie_allocator& allocator, u64 nodeSize, bool leaf) {
+  u64 lineOffset = (uintptr_t)allocator.freeBytes & (adaptiveTrieCacheLineSize - 1);
+  bool fitsInLine = leaf && lineOffset + nodeSize <= adaptiveTrieCacheLineSize;
+  u64 paddingSize = (lineOffset == 0 || fitsInLine) ? 0 : adaptiveTrieCacheLineSize - lineOffset;
+  if(allocator.remainingBytes < paddingSize + nodeSize) {
+    void* newMallocPtr = malloc(allocator.bytesPerMalloc);
+    allocator.mallocPtrs.push_back(newMallocPtr);
+    allocator.freeBytes = (char*)newMallocPtr;
+    allocator.remainingBytes = allocator.bytesPerMalloc;
+    allocator.totalMemoryAllocated += allocator.bytesPerMalloc;
+
+    lineOffset = (uintptr_t)allocator.freeBytes & (adaptiveTrieCacheLineSize - 1);
+    fitsInLine = leaf && lineOffset + nodeSize <= adaptiveTrieCacheLineSize;
+    paddingSize = (lineOffset == 0 || fitsInLine) ? 0 : adaptiveTrieCacheLineSize - lineOffset;
   }
+  char* bytes = allocator.freeBytes + paddingSize;
+  allocator.freeBytes = bytes + nodeSize; // every node size is a multiple of 8
+  allocator.remainingBytes -= paddingSize + nodeSize;
+  return bytes;
+}
 
-  const linked_trie_dictionary_node* parent = &dict.root;
-  u32 wordIndex = 0;
-  u32 wordCharCount = word.size();
-  while(parent != nullptr && wordIndex < wordCharCount) {
-    char character = word[wordIndex++];
+// Returns a node of the requested type with no children
+adaptive_trie_node* nextFree(adaptive_trie_allocator& allocator, adaptive_trie_node_type type) {
+  adaptive_trie_node* node = allocator.recycledNodes[type];
+  if(node != nullptr) {
+    allocator.recycledNodes[type] = *childrenOf(node);
+  } else {
+    node = (adaptive_trie_node*)nextFreeBytes(allocator, adaptiveTrieNodeSizes[type], false);
+  }
 
-    if(parent->firstChild == nullptr) {
-      printf("A non-null termination node should not have null child. It should either contain the next letters or a null termination node.");
-      return false;
-    }
+  node->type = type;
+  node->endOfWord = false;
+  node->childCount = 0;
+  node->prefixLength = 0;
+  if(type == AdaptiveTrieNode256) {
+    memset(((adaptive_trie_node256*)node)->children, 0, 256 * sizeof(adaptive_trie_node*));
+  }
+  allocator.nodeCounts[type]++;
+  return node;
+}
 
-    linked_trie_dictionary_node* child = parent->firstChild;
-    while(child != nullptr) {
-      if(child->character == character) {
-        parent = child;
-        break;
-      }
-      child = child->nextSibling;
-    }
-    if(parent != child) { // if character not found
-      return false;
-    }
+// Returns a leaf with room for prefixLength bytes of prefix, which the caller fills in
+adaptive_trie_node* nextFreeLeaf(adaptive_trie_allocator& allocator, u64 prefixLength) {
+  adaptive_trie_node* leaf = (adaptive_trie_node*)nextFreeBytes(allocator, leafSize(prefixLength), true);
+  leaf->type = AdaptiveTrieLeaf;
+  leaf->endOfWord = false;
+  leaf->childCount = 0;
+  leaf->prefixLength = (u8)prefixLength;
+  allocator.nodeCounts[AdaptiveTrieLeaf]++;
+  return leaf;
+}
+
+// Moves an inline leaf into a leaf node, so words can be added below it or split it
+adaptive_trie_node* uninlineLeaf(adaptive_trie_allocator& allocator, adaptive_trie_node** leafSlot) {
+  const u64 leafBytes = (uintptr_t)*leafSlot >> 8;
+  const u64 length = inlineLeafLength(*leafSlot);
+  adaptive_trie_node* leaf = nextFreeLeaf(allocator, length);
+  memcpy(leaf->prefix, &leafBytes, length);
+  leaf->endOfWord = true;
+  *leafSlot = leaf;
+  return leaf;
+}
+
+void recycle(adaptive_trie_allocator& allocator, adaptive_trie_node* node) {
+  *childrenOf(node) = allocator.recycledNodes[node->type];
+  allocator.recycledNodes[node->type] = node;
+  allocator.nodeCounts[node->type]--;
+}
+
+// Returns the slot holding the child for key, nullptr if there is no such child
+inline adaptive_trie_node** findChildSlot(adaptive_trie_node* node, u8 key) {
+  if(node->childCount == 0) { // a leaf, whose bytes after the header are more prefix, or an empty root
+    return nullptr;
+  }
+  if(node->type == AdaptiveTrieNode256) {
+    adaptive_trie_node256* node256 = (adaptive_trie_node256*)node;
+    return (node256->children[key] != nullptr) ? &node256->children[key] : nullptr;
   }
 
-  return parent->endOfWord;
+  // a node4 compares the start of its children too, those bytes are masked off with the unused keys
+  const __m128i keys = _mm_loadu_si128((const __m128i*)keysOf(node));
+  const __m128i matches = _mm_cmpeq_epi8(keys, _mm_set1_epi8((char)key));
+  const u32 matchMask = (u32)_mm_movemask_epi8(matches) & ((1u << node->childCount) - 1);
+  return (matchMask != 0) ? &childrenOf(node)[countTrailingZeros(matchMask)] : nullptr;
 }
 
-void buildDictionary(const std::vector<char>& fileCharacters, linked_trie_dictionary_no_allocator& outDict) {
-  // init dictionary to hold nothing
-  outDict.root.character = '*';
-  outDict.root.nextSibling = nullptr;
-  outDict.root.firstChild = nullptr;
-  outDict.nodeCount = 0;
+// Adds child under key to a node that has room for it. Returns the slot the child was written to.
+adaptive_trie_node** writeChild(adaptive_trie_node* node, u8 key, adaptive_trie_node* child) {
+  adaptive_trie_node** childSlot;
+  if(node->type == AdaptiveTrieNode256) {
+    childSlot = &childrenOf(node)[key];
+  } else {
+    keysOf(node)[node->childCount] = key;
+    childSlot = &childrenOf(node)[node->childCount];
+  }
+  *childSlot = child;
+  node->childCount++;
+  return childSlot;
+}
 
-  u32 fileCharactersCount = fileCharacters.size();
-  for(u32 fileCharacterIndex = 0; fileCharacterIndex < fileCharactersCount; fileCharacterIndex++) {
-    char fileCharacter = fileCharacters[fileCharacterIndex];
+// Moves every child of node into a node of the next larger type, recycles node and points nodeSlot at the new node
+adaptive_trie_node* grow(adaptive_trie_allocator& allocator, adaptive_trie_node** nodeSlot) {
+  adaptive_trie_node* node = *nodeSlot;
+  Assert(node->type < AdaptiveTrieNode256);
+  adaptive_trie_node* grownNode = nextFree(allocator, (adaptive_trie_node_type)(node->type + 1));
+  grownNode->endOfWord = node->endOfWord;
+  grownNode->prefixLength = node->prefixLength;
+  memcpy(grownNode->prefix, node->prefix, node->prefixLength);
 
-    // TODO: handle uppercase
-    if((fileCharacter < 'a' || fileCharacter > 'z') && fileCharacter != '-') {
-      continue;
+  const u8* keys = keysOf(node);
+  adaptive_trie_node** children = childrenOf(node);
+  for(u32 i = 0; i < node->childCount; i++) {
+    writeChild(grownNode, keys[i], children[i]);
+  }
+
+  recycle(allocator, node);
+  *nodeSlot = grownNode;
+  return grownNode;
+}
+
+// Turns a leaf whose prefix fits in a node4 into one, so it can take children. The leaf's bytes are not reused.
+adaptive_trie_node* expandLeaf(adaptive_trie_allocator& allocator, adaptive_trie_node** leafSlot) {
+  adaptive_trie_node* leaf = *leafSlot;
+  Assert(leaf->prefixLength <= adaptiveTriePrefixCapacity);
+  adaptive_trie_node* node = nextFree(allocator, AdaptiveTrieNode4);
+  node->endOfWord = leaf->endOfWord;
+  node->prefixLength = leaf->prefixLength;
+  memcpy(node->prefix, leaf->prefix, leaf->prefixLength);
+  allocator.nodeCounts[AdaptiveTrieLeaf]--;
+  *leafSlot = node;
+  return node;
+}
+
+void insertWord(adaptive_trie_node** rootSlot, adaptive_trie_allocator& allocator, const char* word, u64 wordCharCount) {
+  adaptive_trie_node** nodeSlot = rootSlot;
+  u64 wordIndex = 0;
+  while(true) {
+    adaptive_trie_node* node = *nodeSlot;
+    if(isInlineLeaf(node)) {
+      node = uninlineLeaf(allocator, nodeSlot);
     }
 
-    linked_trie_dictionary_node* parent = &outDict.root;
-    while(fileCharacterIndex < fileCharactersCount) {
-      fileCharacter = fileCharacters[fileCharacterIndex++];
-      if((fileCharacter < 'a' || fileCharacter > 'z') && fileCharacter != '-') {
-        break;
-      }
+    u32 matchLength = 0;
+    while(matchLength < node->prefixLength && wordIndex + matchLength < wordCharCount &&
+          (u8)word[wordIndex + matchLength] == node->prefix[matchLength]) {
+      matchLength++;
+    }
 
-      linked_trie_dictionary_node* child = parent->firstChild;
+    // Split the node where the word leaves or ends inside its prefix. The node above the split holds at most
+    // adaptiveTriePrefixCapacity bytes, so a leaf is also split when the word runs past a prefix too long for a node4.
+    const bool runsPastLeaf = node->type == AdaptiveTrieLeaf && wordIndex + matchLength < wordCharCount;
+    if(matchLength < node->prefixLength || (runsPastLeaf && node->prefixLength > adaptiveTriePrefixCapacity)) {
+      const u32 splitLength = MIN(matchLength, adaptiveTriePrefixCapacity);
+      adaptive_trie_node* splitNode = nextFree(allocator, AdaptiveTrieNode4);
+      splitNode->prefixLength = (u8)splitLength;
+      memcpy(splitNode->prefix, node->prefix, splitLength);
+      writeChild(splitNode, node->prefix[splitLength], node);
+      node->prefixLength -= (u8)(splitLength + 1);
+      memmove(node->prefix, node->prefix + splitLength + 1, node->prefixLength);
+      *nodeSlot = splitNode;
+      node = splitNode;
+      matchLength = splitLength;
+    }
+    wordIndex += matchLength;
 
-      // search for character amongst children
-      while(child != nullptr) {
-        if(child->character == fileCharacter) {
-          parent = child;
-          break;
-        }
-        child = child->nextSibling;
+    if(wordIndex == wordCharCount) {
+      node->endOfWord = true;
+      return;
+    }
+
+    if(node->type == AdaptiveTrieLeaf) {
+      node = expandLeaf(allocator, nodeSlot);
+    }
+    const u8 key = (u8)word[wordIndex++];
+    adaptive_trie_node** childSlot = findChildSlot(node, key);
+    if(childSlot == nullptr) {
+      if(node->childCount == adaptiveTrieNodeCapacities[node->type]) {
+        node = grow(allocator, nodeSlot);
       }
+      if(wordCharCount - wordIndex <= adaptiveTrieInlineLeafCapacity) {
+        writeChild(node, key, inlineLeaf(word + wordIndex, wordCharCount - wordIndex));
+        return;
+      }
+      // the rest of the word goes into one leaf, as much as fits, and the next pass matches it
+      const u64 leafPrefixLength = MIN(wordCharCount - wordIndex, (u64)adaptiveTrieLeafPrefixCapacity);
+      adaptive_trie_node* leaf = nextFreeLeaf(allocator, leafPrefixLength);
+      memcpy(leaf->prefix, word + wordIndex, leafPrefixLength);
+      childSlot = writeChild(node, key, leaf);
+    }
+    nodeSlot = childSlot;
+  }
+}
 
-      // if character not found, create new one
-      if(parent != child) {
-        child = new linked_trie_dictionary_node;
-        outDict.nodeCount++;
-        child->character = fileCharacter;
-        child->nextSibling = parent->firstChild;
-        parent->firstChild = child;
-        child->firstChild = nullptr;
-        child->endOfWord = false;
-        parent = child;
+void freeDictionary(adaptive_trie_dictionary& dict) {
+  dict.root = nullptr;
+  for(void* mallocPtr : dict.allocator.mallocPtrs) {
+    free(mallocPtr);
+  }
+  dict.allocator = {};
+}
+
+// Compares the node's prefix against the word 16 bytes at a time. The word must be readable for 16 bytes past its end.
+bool matchesPrefix(const adaptive_trie_node* node, const u8* character) {
+  const u8* prefix = node->prefix;
+  u32 remainingLength = node->prefixLength;
+  while(true) {
+    const __m128i matches = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)prefix), _mm_loadu_si128((const __m128i*)character));
+    const u32 comparedMask = (1u << MIN(remainingLength, 16u)) - 1;
+    if((~(u32)_mm_movemask_epi8(matches) & comparedMask) != 0) {
+      return false;
+    }
+    if(remainingLength <= 16) {
+      return true;
+    }
+    remainingLength -= 16;
+    prefix += 16;
+    character += 16;
+  }
+}
+
+bool contains(const adaptive_trie_dictionary& dict, const std::string& word) {
+  adaptive_trie_node* node = dict.root;
+  if(node == nullptr) { // freed
+    return false;
+  }
+
+  // The word is copied with 16 zeros after it, so matchesPrefix() and inline leaves can read past its end. Zero is a delimiter, no prefix
+  // byte equals it, so a prefix longer than the rest of the word never matches.
+  u8 shortWord[64 + 16];
+  std::vector<u8> longWord;
+  u8* paddedWord = shortWord;
+  if(word.size() > 64) {
+    longWord.resize(word.size() + 16);
+    paddedWord = longWord.data();
+  }
+  memcpy(paddedWord, word.data(), word.size());
+  memset(paddedWord + word.size(), 0, 16);
+
+  const u8* character = paddedWord;
+  const u8* end = character + word.size();
+  while(true) {
+    // Most nodes near the root have no prefix. Branching on that first, rather than always adding prefixLength, lets
+    // the next key byte be read before the node arrives.
+    if(node->prefixLength != 0) {
+      if(!matchesPrefix(node, character)) {
+        return false;
       }
+      character += node->prefixLength;
     }
 
-    parent->endOfWord = true;
+    if(character == end) {
+      return node->endOfWord;
+    }
+
+    adaptive_trie_node** childSlot = findChildSlot(node, *character++);
+    if(childSlot == nullptr) {
+      return false;
+    }
+    node = *childSlot;
+
+    if(isInlineLeaf(node)) {
+      u64 wordBytes; // the padding makes 8 bytes readable
+      memcpy(&wordBytes, character, sizeof(wordBytes));
+      const u64 length = inlineLeafLength(node);
+      const u64 lengthMask = (1ull << (length * 8)) - 1;
+      return (u64)(end - character) == length && (wordBytes & lengthMask) == ((uintptr_t)node >> 8);
+    }
   }
 }
+
+void buildDictionary(const char* characters, u64 charactersCount, adaptive_trie_dictionary& outDict) {
+  // The average word length in the English dictionary is 4.7, most nodes end up as node4s and prefixes hold about half
+  const u64 initialByteCountEstimate = (charactersCount / 8) * sizeof(adaptive_trie_node4);
+  initAllocator(outDict.allocator, initialByteCountEstimate);
+  outDict.root = nextFree(outDict.allocator, AdaptiveTrieNode4);
+
+  u64 characterIndex = 0;
+  while(characterIndex < charactersCount) {
+    if(isByteWordDelimiter(characters[characterIndex])) {
+      characterIndex++;
+      continue;
+    }
+
+    const u64 wordBegin = characterIndex;
+    while(characterIndex < charactersCount && !isByteWordDelimiter(characters[characterIndex])) {
+      characterIndex++;
+    }
+    insertWord(&outDict.root, outDict.allocator, characters + wordBegin, characterIndex - wordBegin);
+  }
+}
+
+void buildDictionary(const std::vector<char>& fileCharacters, adaptive_trie_dictionary& outDict) {
+  buildDictionary(fileCharacters.data(), fileCharacters.size(), outDict);
+}
+
+// ==== PARALLEL CONSTRUCTION
+// The root's children partition the words by their first character. The file is split into one chunk per thread at word
+// boundaries and each chunk is scanned for runs of consecutive words that share a first character. Each thread then
+// owns a range of first characters and builds those sub-tries into its own allocator. The sub-tries are linked under the
+// root once every thread has finished, so no synchronization is needed while building.
+struct dictionary_word_run {
+  u64 begin;
+  u64 end;
+};
+
+struct dictionary_chunk_runs {
+  std::vector<dictionary_word_run> runs[supportedLetterCount];
+  u64 characterCounts[supportedLetterCount];
+};
+
+u32 dictionaryBuildThreadCount(u32 requestedThreadCount) {
+  u32 threadCount = requestedThreadCount;
+  if(threadCount == 0) {
+    threadCount = std::thread::hardware_concurrency();
+  }
+  return CLAMP(threadCount, 1, supportedLetterCount);
+}
+
+void scanWordRuns(const char* characters, u64 chunkBegin, u64 chunkEnd, dictionary_chunk_runs& outChunk) {
+  for(u32 i = 0; i < supportedLetterCount; i++) {
+    outChunk.runs[i].clear();
+    outChunk.characterCounts[i] = 0;
+  }
+
+  dictionary_word_run run{};
+  u32 runLetterIndex = U32_MAX;
+  u64 characterIndex = chunkBegin;
+  while(characterIndex < chunkEnd) {
+    if(!isWordCharacter(characters[characterIndex])) {
+      characterIndex++;
+      continue;
+    }
+
+    const u64 wordBegin = characterIndex;
+    const u32 wordLetterIndex = letterIndex(characters[wordBegin]);
+    while(characterIndex < chunkEnd && isWordCharacter(characters[characterIndex])) {
+      characterIndex++;
+    }
+
+    if(wordLetterIndex != runLetterIndex) {
+      if(runLetterIndex != U32_MAX) {
+        outChunk.runs[runLetterIndex].push_back(run);
+      }
+      runLetterIndex = wordLetterIndex;
+      run.begin = wordBegin;
+    }
+    run.end = characterIndex;
+    outChunk.characterCounts[wordLetterIndex] += characterIndex - wordBegin + 1;
+  }
+
+  if(runLetterIndex != U32_MAX) {
+    outChunk.runs[runLetterIndex].push_back(run);
+  }
+}
+
+// Splits the characters into threadCount chunks without splitting any words and fills in each chunk's word runs
+void scanChunksParallel(const char* characters, u64 charactersCount, u32 threadCount, std::vector<dictionary_chunk_runs>& outChunks) {
+  std::vector<u64> chunkBoundaries(threadCount + 1);
+  chunkBoundaries[0] = 0;
+  for(u32 i = 1; i < threadCount; i++) {
+    u64 boundary = MAX(charactersCount * i / threadCount, chunkBoundaries[i - 1]);
+    while(boundary > 0 && boundary < charactersCount && isWordCharacter(characters[boundary - 1])) {
+      boundary++;
+    }
+    chunkBoundaries[i] = boundary;
+  }
+  chunkBoundaries[threadCount] = charactersCount;
+
+  outChunks.resize(threadCount);
+  std::vector<std::thread> threads;
+  threads.reserve(threadCount);
+  for(u32 i = 0; i < threadCount; i++) {
+    threads.emplace_back(scanWordRuns, characters, chunkBoundaries[i], chunkBoundaries[i + 1], std::ref(outChunks[i]));
+  }
+  for(std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+// Assigns each thread a contiguous range of first letters [outFirstLetters[i], outFirstLetters[i + 1]) of roughly equal work
+void partitionLetters(const std::vector<dictionary_chunk_runs>& chunks, u32 threadCount, std::vector<u32>& outFirstLetters) {
+  u64 letterCharacterCounts[supportedLetterCount] = {};
+  u64 totalCharacterCount = 0;
+  for(const dictionary_chunk_runs& chunk : chunks) {
+    for(u32 i = 0; i < supportedLetterCount; i++) {
+      letterCharacterCounts[i] += chunk.characterCounts[i];
+      totalCharacterCount += chunk.characterCounts[i];
+    }
+  }
+
+  outFirstLetters.assign(threadCount + 1, supportedLetterCount);
+  outFirstLetters[0] = 0;
+  u64 accumulatedCharacterCount = 0;
+  u32 threadIndex = 1;
+  for(u32 i = 0; i < supportedLetterCount && threadIndex < threadCount; i++) {
+    accumulatedCharacterCount += letterCharacterCounts[i];
+    if(accumulatedCharacterCount * threadCount >= totalCharacterCount * threadIndex) {
+      outFirstLetters[threadIndex++] = i + 1;
+    }
+  }
+}
+
+template<typename Node, typename Allocator>
+void buildSubTries(const char* characters, const std::vector<dictionary_chunk_runs>& chunks, u32 firstLetter, u32 endLetter,
+                   Node* outRoot, Allocator& outAllocator) {
+  u64 characterCount = 0;
+  for(const dictionary_chunk_runs& chunk : chunks) {
+    for(u32 i = firstLetter; i < endLetter; i++) {
+      characterCount += chunk.characterCounts[i];
+    }
+  }
+  initAllocator(outAllocator, characterCount / 4); // The average word length in the English dictionary is 4.7
+
+  for(u32 i = firstLetter; i < endLetter; i++) {
+    for(const dictionary_chunk_runs& chunk : chunks) {
+      for(const dictionary_word_run& run : chunk.runs[i]) {
+        u64 characterIndex = run.begin;
+        while(characterIndex < run.end) {
+          if(!isWordCharacter(characters[characterIndex])) {
+            characterIndex++;
+            continue;
+          }
+
+          const u64 wordBegin = characterIndex;
+          while(characterIndex < run.end && isWordCharacter(characters[characterIndex])) {
+            characterIndex++;
+          }
+          insertWord(outRoot, outAllocator, characters + wordBegin, characterIndex - wordBegin);
+        }
+      }
+    }
+  }
+}
+
+// Hands every node block of the thread allocators over to the dictionary's allocator
+template<typename Allocator>
+void mergeAllocators(std::vector<Allocator>& threadAllocators, Allocator& outAllocator) {
+  outAllocator = {};
+  for(Allocator& threadAllocator : threadAllocators) {
+    outAllocator.mallocPtrs.insert(outAllocator.mallocPtrs.end(), threadAllocator.mallocPtrs.begin(), threadAllocator.mallocPtrs.end());
+    outAllocator.totalMemoryAllocated += threadAllocator.totalMemoryAllocated;
+    outAllocator.nodeCountPerMalloc = MAX(outAllocator.nodeCountPerMalloc, threadAllocator.nodeCountPerMalloc);
+  }
+
+  // keep handing out nodes from the last thread's current block
+  outAllocator.freeNodes = threadAllocators.back().freeNodes;
+  outAllocator.remainingNodes = threadAllocators.back().remainingNodes;
+}
+
+// threadCount of 0 uses std::thread::hardware_concurrency()
+void buildDictionaryParallel(const char* characters, u64 charactersCount, linked_trie_dictionary& outDict, u32 threadCount = 0) {
+  threadCount = dictionaryBuildThreadCount(threadCount);
+
+  std::vector<dictionary_chunk_runs> chunks;
+  scanChunksParallel(characters, charactersCount, threadCount, chunks);
+
+  std::vector<u32> firstLetters;
+  partitionLetters(chunks, threadCount, firstLetters);
+
+  std::vector<linked_trie_dictionary_node> threadRoots(threadCount);
+  std::vector<linked_trie_dictionary_allocator> threadAllocators(threadCount);
+  std::vector<std::thread> threads;
+  threads.reserve(threadCount);
+  for(u32 i = 0; i < threadCount; i++) {
+    threadRoots[i] = {};
+    threads.emplace_back(buildSubTries<linked_trie_dictionary_node, linked_trie_dictionary_allocator>,
+                         characters, std::cref(chunks), firstLetters[i], firstLetters[i + 1],
+                         &threadRoots[i], std::ref(threadAllocators[i]));
+  }
+  for(std::thread& thread : threads) {
+    thread.join();
+  }
+
+  // link sub-tries under the root
+  outDict.root.character = '*';
+  outDict.root.endOfWord = false;
+  outDict.root.frequency = 0;
+  outDict.root.maxFrequency = 0;
+  outDict.root.nextSibling = nullptr;
+  outDict.root.firstChild = nullptr;
+  for(linked_trie_dictionary_node& threadRoot : threadRoots) {
+    linked_trie_dictionary_node* child = threadRoot.firstChild;
+    while(child != nullptr) {
+      linked_trie_dictionary_node* nextChild = child->nextSibling;
+      child->nextSibling = outDict.root.firstChild;
+      outDict.root.firstChild = child;
+      child = nextChild;
+    }
+  }
+
+  mergeAllocators(threadAllocators, outDict.allocator);
+}
+
+// threadCount of 0 uses std::thread::hardware_concurrency()
+void buildDictionaryParallel(const std::vector<char>& fileCharacters, linked_trie_dictionary& outDict, u32 threadCount = 0) {
+  buildDictionaryParallel(fileCharacters.data(), fileCharacters.size(), outDict, threadCount);
+}
+
+// threadCount of 0 uses std::thread::hardware_concurrency()
+void buildDictionaryParallel(const char* characters, u64 charactersCount, trie_dictionary& outDict, u32 threadCount = 0) {
+  threadCount = dictionaryBuildThreadCount(threadCount);
+
+  std::vector<dictionary_chunk_runs> chunks;
+  scanChunksParallel(characters, charactersCount, threadCount, chunks);
+
+  std::vector<u32> firstLetters;
+  partitionLetters(chunks, threadCount, firstLetters);
+
+  std::vector<trie_dictionary_node> threadRoots(threadCount);
+  std::vector<trie_dictionary_allocator> threadAllocators(threadCount);
+  std::vector<std::thread> threads;
+  threads.reserve(threadCount);
+  for(u32 i = 0; i < threadCount; i++) {
+    threadRoots[i] = {};
+    threads.emplace_back(buildSubTries<trie_dictionary_node, trie_dictionary_allocator>,
+                         characters, std::cref(chunks), firstLetters[i], firstLetters[i + 1],
+                         &threadRoots[i], std::ref(threadAllocators[i]));
+  }
+  for(std::thread& thread : threads) {
+    thread.join();
+  }
+
+  // link sub-tries under the root
+  outDict.root = {};
+  for(u32 i = 0; i < threadCount; i++) {
+    for(u32 letter = firstLetters[i]; letter < firstLetters[i + 1]; letter++) {
+      outDict.root.children[letter] = threadRoots[i].children[letter];
+    }
+  }
+
+  mergeAllocators(threadAllocators, outDict.allocator);
+}
+
+// threadCount of 0 uses std::thread::hardware_concurrency()
+void buildDictionaryParallel(const std::vector<char>& fileCharacters, trie_dictionary& outDict, u32 threadCount = 0) {
+  buildDictionaryParallel(fileCharacters.data(), fileCharacters.size(), outDict, threadCount);
+}
+
+// ==== STREAMING CONSTRUCTION
+// Builds from a FILE* (a file, stdin or a pipe) without ever holding more than one chunk of it in memory. A word cut
+// off by the end of a chunk is moved to the front of the buffer and finished by the next read. A word longer than a
+// whole chunk grows the buffer.
+const u64 streamingChunkSize = 1 << 20;
+
+template<typename IsWordCharacter, typename InsertWord>
+void forEachStreamedWord(FILE* file, u64 chunkSize, IsWordCharacter isWordCharacterFunc, InsertWord insertWordFunc) {
+  std::vector<char> buffer(MAX(chunkSize, 1));
+  u64 carriedCount = 0;
+  bool endOfFile = false;
+  while(!endOfFile) {
+    if(carriedCount == buffer.size()) {
+      buffer.resize(buffer.size() * 2);
+    }
+    const u64 readCount = fread(buffer.data() + carriedCount, 1, buffer.size() - carriedCount, file);
+    endOfFile = (readCount == 0);
+
+    const char* characters = buffer.data();
+    const u64 charactersCount = carriedCount + readCount;
+    u64 characterIndex = 0;
+    carriedCount = 0;
+    while(characterIndex < charactersCount) {
+      if(!isWordCharacterFunc(characters[characterIndex])) {
+        characterIndex++;
+        continue;
+      }
+
+      const u64 wordBegin = characterIndex;
+      while(characterIndex < charactersCount && isWordCharacterFunc(characters[characterIndex])) {
+        characterIndex++;
+      }
+
+      if(characterIndex == charactersCount && !endOfFile) { // the rest of the word hasn't been read yet
+        carriedCount = characterIndex - wordBegin;
+        memmove(buffer.data(), characters + wordBegin, carriedCount);
+      } else {
+        insertWordFunc(characters + wordBegin, characterIndex - wordBegin);
+      }
+    }
+  }
+}
+
+void buildDictionary(FILE* file, linked_trie_dictionary& outDict, u64 chunkSize = streamingChunkSize) {
+  // the total size is unknown, so grow by a chunk's worth of bytes at a time
+  const u64 nodeCountPerChunk = MAX(chunkSize / sizeof(linked_trie_dictionary_node), 64);
+  initAllocator(outDict.allocator, nodeCountPerChunk);
+  outDict.allocator.nodeCountPerMalloc = (u32)nodeCountPerChunk;
+
+  outDict.root.character = '*';
+  outDict.root.endOfWord = false;
+  outDict.root.frequency = 0;
+  outDict.root.maxFrequency = 0;
+  outDict.root.nextSibling = nullptr;
+  outDict.root.firstChild = nullptr;
+
+  forEachStreamedWord(file, chunkSize, isWordCharacter, [&](const char* word, u64 wordCharCount) {
+    insertWord(&outDict.root, outDict.allocator, word, wordCharCount);
+  });
+}
+
+void buildDictionary(FILE* file, trie_dictionary& outDict, u64 chunkSize = streamingChunkSize) {
+  // the total size is unknown, so grow by a chunk's worth of bytes at a time
+  outDict.root = {};
+  const u64 nodeCountPerChunk = MAX(chunkSize / sizeof(trie_dictionary_node), 64);
+  initAllocator(outDict.allocator, nodeCountPerChunk);
+  outDict.allocator.nodeCountPerMalloc = (u32)nodeCountPerChunk;
+
+  forEachStreamedWord(file, chunkSize, isWordCharacter, [&](const char* word, u64 wordCharCount) {
+    insertWord(&outDict.root, outDict.allocator, word, wordCharCount);
+  });
+}
+
+void buildDictionary(FILE* file, adaptive_trie_dictionary& outDict, u64 chunkSize = streamingChunkSize) {
+  // the total size is unknown, so grow by a chunk's worth of bytes at a time
+  const u64 bytesPerChunk = MAX(chunkSize, sizeof(adaptive_trie_node256) + adaptiveTrieCacheLineSize);
+  initAllocator(outDict.allocator, bytesPerChunk);
+  outDict.allocator.bytesPerMalloc = bytesPerChunk;
+  outDict.root = nextFree(outDict.allocator, AdaptiveTrieNode4);
+
+  auto isByteWordCharacter = [](char c) { return !isByteWordDelimiter(c); };
+  forEachStreamedWord(file, chunkSize, isByteWordCharacter, [&](const char* word, u64 wordCharCount) {
+    insertWord(&outDict.root, outDict.allocator, word, wordCharCount);
+  });
+}
+
+// ==== BATCHED CONTAINS
+// A single contains() is a chain of dependent loads, so the CPU sits idle waiting on memory at every level of the trie.
+// The batched versions keep containsBatchWidth words in flight and advance each of them one step per pass, prefetching
+// the memory the next step will touch. By the time a word is revisited its node has usually arrived in cache.
+const u32 containsBatchWidth = 16;
+
+void prefetch(const void* address) {
+  _mm_prefetch((const char*)address, _MM_HINT_T0);
+}
+
+struct contains_batch_lane {
+  const char* character;
+  const char* end;
+  u32 wordIndex;
+};
+
+// Points the lane at the next unprocessed word. Returns false when there are no words left.
+bool nextBatchWord(contains_batch_lane& lane, const std::string_view* words, u32 count, u32& nextWordIndex) {
+  if(nextWordIndex == count) {
+    return false;
+  }
+  lane.wordIndex = nextWordIndex++;
+  lane.character = words[lane.wordIndex].data();
+  lane.end = lane.character + words[lane.wordIndex].size();
+  return true;
+}
+
+void containsBatch(const trie_dictionary& dict, const std::string_view* words, u32 count, bool* out) {
+  contains_batch_lane lanes[containsBatchWidth];
+  const trie_dictionary_node* laneNodes[containsBatchWidth];
+  u32 nextWordIndex = 0;
+  u32 activeCount = 0;
+  while(activeCount < containsBatchWidth && nextBatchWord(lanes[activeCount], words, count, nextWordIndex)) {
+    laneNodes[activeCount++] = &dict.root;
+  }
+
+  while(activeCount > 0) {
+    u32 laneIndex = 0;
+    while(laneIndex < activeCount) {
+      contains_batch_lane& lane = lanes[laneIndex];
+      const trie_dictionary_node* node = laneNodes[laneIndex];
+
+      bool finished = true;
+      if(lane.character == lane.end) {
+        out[lane.wordIndex] = node->endOfWord;
+      } else if(!isWordCharacter(*lane.character)) {
+        out[lane.wordIndex] = false;
+      } else {
+        const trie_dictionary_node* child = node->children[letterIndex(*lane.character++)];
+        if(child == nullptr) {
+          out[lane.wordIndex] = false;
+        } else {
+          finished = false;
+          laneNodes[laneIndex] = child;
+          if(lane.character != lane.end && isWordCharacter(*lane.character)) {
+            prefetch(&child->children[letterIndex(*lane.character)]);
+          } else {
+            prefetch(child);
+          }
+        }
+      }
+
+      if(!finished) {
+        laneIndex++;
+      } else if(nextBatchWord(lane, words, count, nextWordIndex)) {
+        laneNodes[laneIndex++] = &dict.root;
+      } else { // no words left to start, shrink the batch
+        activeCount--;
+        lanes[laneIndex] = lanes[activeCount];
+        laneNodes[laneIndex] = laneNodes[activeCount];
+      }
+    }
+  }
+}
+
+void containsBatch(const linked_trie_dictionary& dict, const std::string_view* words, u32 count, bool* out) {
+  contains_batch_lane lanes[containsBatchWidth];
+  const linked_trie_dictionary_node* laneSiblings[containsBatchWidth]; // candidate child for the lane's current character
+  u32 nextWordIndex = 0;
+  u32 activeCount = 0;
+  while(activeCount < containsBatchWidth && nextBatchWord(lanes[activeCount], words, count, nextWordIndex)) {
+    laneSiblings[activeCount++] = dict.root.firstChild;
+  }
+
+  while(activeCount > 0) {
+    u32 laneIndex = 0;
+    while(laneIndex < activeCount) {
+      contains_batch_lane& lane = lanes[laneIndex];
+      const linked_trie_dictionary_node* sibling = laneSiblings[laneIndex];
+
+      bool finished = true;
+      if(lane.character == lane.end) { // only reached by empty words
+        out[lane.wordIndex] = dict.root.endOfWord;
+      } else if(sibling == nullptr) { // character not found
+        out[lane.wordIndex] = false;
+      } else if(sibling->character != *lane.character) {
+        finished = false;
+        laneSiblings[laneIndex] = sibling->nextSibling;
+        prefetch(sibling->nextSibling);
+      } else if(++lane.character == lane.end) {
+        out[lane.wordIndex] = sibling->endOfWord;
+      } else {
+        finished = false;
+        laneSiblings[laneIndex] = sibling->firstChild;
+        prefetch(sibling->firstChild);
+      }
+
+      if(!finished) {
+        laneIndex++;
+      } else if(nextBatchWord(lane, words, count, nextWordIndex)) {
+        laneSiblings[laneIndex++] = dict.root.firstChild;
+      } else { // no words left to start, shrink the batch
+        activeCount--;
+        lanes[laneIndex] = lanes[activeCount];
+        laneSiblings[laneIndex] = laneSiblings[activeCount];
+      }
+    }
+  }
+}
+
+// ==== PREFIX QUERIES
+// Frequencies come from a list of words ordered from most to least frequent. The word ranked first gets a frequency of
+// 65535 and each following word one less, bottoming out at 1. A frequency of 0 means the word was not ranked. Each node
+// also caches the max frequency found in its subtree so that top-K queries can skip subtrees that cannot place.
+char letterCharacter(u32 letterIndex) {
+  return (letterIndex == 26) ? '-' : (char)('a' + letterIndex);
+}
+
+linked_trie_dictionary_node* findChild(const linked_trie_dictionary_node* parent, char character) {
+  linked_trie_dictionary_node* child = parent->firstChild;
+  while(child != nullptr && child->character != character) {
+    child = child->nextSibling;
+  }
+  return child;
+}
+
+trie_dictionary_node* findChild(const trie_dictionary_node* parent, char character) {
+  if(!isWordCharacter(character)) {
+    return nullptr;
+  }
+  return parent->children[letterIndex(character)];
+}
+
+template<typename F>
+void forEachChild(const linked_trie_dictionary_node* parent, F func) {
+  for(const linked_trie_dictionary_node* child = parent->firstChild; child != nullptr; child = child->nextSibling) {
+    func(child, child->character);
+  }
+}
+
+template<typename F>
+void forEachChild(const trie_dictionary_node* parent, F func) {
+  for(u32 i = 0; i < supportedLetterCount; i++) {
+    if(parent->children[i] != nullptr) {
+      func(parent->children[i], letterCharacter(i));
+    }
+  }
+}
+
+// Returns the node reached by following the characters from root, nullptr if there is no such path
+template<typename Node>
+Node* findNode(Node* root, const char* characters, u64 characterCount) {
+  Node* node = root;
+  for(u64 i = 0; i < characterCount && node != nullptr; i++) {
+    node = findChild(node, characters[i]);
+  }
+  return node;
+}
+
+template<typename Node>
+void loadWordFrequencies(const char* characters, u64 charactersCount, Node* root) {
+  std::vector<Node*> path;
+  u16 frequency = U16_MAX;
+  u64 characterIndex = 0;
+  while(characterIndex < charactersCount) {
+    if(!isWordCharacter(characters[characterIndex])) {
+      characterIndex++;
+      continue;
+    }
+
+    const u64 wordBegin = characterIndex;
+    while(characterIndex < charactersCount && isWordCharacter(characters[characterIndex])) {
+      characterIndex++;
+    }
+
+    path.clear();
+    path.push_back(root);
+    for(u64 i = wordBegin; i < characterIndex && path.back() != nullptr; i++) {
+      path.push_back(findChild(path.back(), characters[i]));
+    }
+
+    const u16 wordFrequency = frequency;
+    frequency = MAX(frequency - 1, 1);
+
+    Node* wordNode = path.back();
+    if(wordNode == nullptr || !wordNode->endOfWord) { // ranked word missing from the dictionary
+      continue;
+    }
+    wordNode->frequency = MAX(wordNode->frequency, wordFrequency);
+    for(Node* node : path) {
+      node->maxFrequency = MAX(node->maxFrequency, wordFrequency);
+    }
+  }
+}
+
+template<typename Node>
+void collectWords(const Node* node, std::string& word, std::vector<std::string>& outWords, u64 maxWordCount) {
+  if(node->endOfWord) {
+    outWords.push_back(word);
+  }
+  forEachChild(node, [&](const Node* child, char character) {
+    if(outWords.size() < maxWordCount) {
+      word.push_back(character);
+      collectWords(child, word, outWords, maxWordCount);
+      word.pop_back();
+    }
+  });
+}
+
+template<typename Node>
+void wordsWithPrefix(const Node* root, const std::string& prefix, std::vector<std::string>& outWords, u64 maxWordCount) {
+  const Node* prefixNode = findNode(root, prefix.data(), prefix.size());
+  if(prefixNode != nullptr) {
+    std::string word = prefix;
+    const u64 wordCountLimit = (maxWordCount == U64_MAX) ? U64_MAX : outWords.size() + maxWordCount;
+    collectWords(prefixNode, word, outWords, wordCountLimit);
+  }
+}
+
+// Best-first search over the subtree of the prefix. Candidates are either a subtree (prioritized by its max frequency)
+// or a word (prioritized by its own frequency). A subtree's max frequency is never lower than anything below it, so
+// words are popped in order of decreasing frequency and subtrees that can't beat the k-th word are never expanded.
+template<typename Node>
+void topCompletions(const Node* root, const std::string& prefix, u32 k, std::vector<std::string>& outWords) {
+  struct completion_entry {
+    const Node* node;
+    u32 parentEntryIndex;
+    char character;
+  };
+  struct completion_candidate {
+    u16 priority;
+    bool isWord;
+    u32 entryIndex;
+    bool operator<(const completion_candidate& other) const {
+      // words win ties so they are emitted before their descendants are expanded
+      return priority < other.priority || (priority == other.priority && !isWord && other.isWord);
+    }
+  };
+
+  const Node* prefixNode = findNode(root, prefix.data(), prefix.size());
+  if(prefixNode == nullptr || k == 0) {
+    return;
+  }
+
+  std::vector<completion_entry> entries;
+  std::priority_queue<completion_candidate> candidates;
+  entries.push_back({prefixNode, U32_MAX, '\0'});
+  candidates.push({prefixNode->maxFrequency, false, 0});
+
+  u32 foundCount = 0;
+  std::string suffix;
+  while(!candidates.empty() && foundCount < k) {
+    const completion_candidate candidate = candidates.top();
+    candidates.pop();
+
+    if(candidate.isWord) {
+      suffix.clear();
+      for(u32 i = candidate.entryIndex; i != 0; i = entries[i].parentEntryIndex) {
+        suffix.push_back(entries[i].character);
+      }
+      outWords.push_back(prefix);
+      outWords.back().append(suffix.rbegin(), suffix.rend());
+      foundCount++;
+      continue;
+    }
+
+    const Node* node = entries[candidate.entryIndex].node;
+    if(node->endOfWord) {
+      candidates.push({node->frequency, true, candidate.entryIndex});
+    }
+    forEachChild(node, [&](const Node* child, char character) {
+      candidates.push({child->maxFrequency, false, (u32)entries.size()});
+      entries.push_back({child, candidate.entryIndex, character});
+    });
+  }
+}
+
+void loadWordFrequencies(const char* rankedCharacters, u64 rankedCharactersCount, linked_trie_dictionary& dict) {
+  loadWordFrequencies(rankedCharacters, rankedCharactersCount, &dict.root);
+}
+
+void loadWordFrequencies(const std::vector<char>& rankedWordCharacters, linked_trie_dictionary& dict) {
+  loadWordFrequencies(rankedWordCharacters.data(), rankedWordCharacters.size(), &dict.root);
+}
+
+void loadWordFrequencies(const char* rankedCharacters, u64 rankedCharactersCount, trie_dictionary& dict) {
+  loadWordFrequencies(rankedCharacters, rankedCharactersCount, &dict.root);
+}
+
+void loadWordFrequencies(const std::vector<char>& rankedWordCharacters, trie_dictionary& dict) {
+  loadWordFrequencies(rankedWordCharacters.data(), rankedWordCharacters.size(), &dict.root);
+}
+
+// Appends the words starting with prefix to outWords, in trie order
+void wordsWithPrefix(const linked_trie_dictionary& dict, const std::string& prefix, std::vector<std::string>& outWords, u64 maxWordCount = U64_MAX) {
+  wordsWithPrefix(&dict.root, prefix, outWords, maxWordCount);
+}
+
+// Appends the words starting with prefix to outWords, in alphabetical order
+void wordsWithPrefix(const trie_dictionary& dict, const std::string& prefix, std::vector<std::string>& outWords, u64 maxWordCount = U64_MAX) {
+  wordsWithPrefix(&dict.root, prefix, outWords, maxWordCount);
+}
+
+// Appends the k most frequent words starting with prefix to outWords, most frequent first
+void topCompletions(const linked_trie_dictionary& dict, const std::string& prefix, u32 k, std::vector<std::string>& outWords) {
+  topCompletions(&dict.root, prefix, k, outWords);
+}
+
+// Appends the k most frequent words starting with prefix to outWords, most frequent first
+void topCompletions(const trie_dictionary& dict, const std::string& prefix, u32 k, std::vector<std::string>& outWords) {
+  topCompletions(&dict.root, prefix, k, outWords);
+}
+
+// ==== FUZZY QUERIES
+// Levenshtein search walking the trie. Each depth keeps one row of the edit distance table between the target word and
+// the path taken to get there, so a child's row only costs O(target length) to compute from its parent's. When every
+// entry of a row exceeds the max distance, no word below that node can be close enough and the subtree is skipped.
+struct dictionary_suggestion {
+  std::string word;
+  u32 distance;
+};
+
+template<typename Node>
+void searchEditDistance(const Node* node, char character, u32 depth, const std::string& target, u32 maxDistance,
+                        u32* rows, std::string& word, std::vector<dictionary_suggestion>& outSuggestions) {
+  const u32 columnCount = (u32)target.size() + 1;
+  const u32* parentRow = rows + (depth - 1) * columnCount;
+  u32* row = rows + depth * columnCount;
+
+  row[0] = depth;
+  u32 rowMin = row[0];
+  for(u32 i = 1; i < columnCount; i++) {
+    const u32 substitutionCost = (target[i - 1] == character) ? 0 : 1;
+    const u32 insertion = row[i - 1] + 1;
+    const u32 deletion = parentRow[i] + 1;
+    const u32 substitution = parentRow[i - 1] + substitutionCost;
+    row[i] = MIN(MIN(insertion, deletion), substitution);
+    rowMin = MIN(rowMin, row[i]);
+  }
+
+  if(node->endOfWord && row[columnCount - 1] <= maxDistance) {
+    outSuggestions.push_back({word, row[columnCount - 1]});
+  }
+
+  if(rowMin <= maxDistance) {
+    forEachChild(node, [&](const Node* child, char childCharacter) {
+      word.push_back(childCharacter);
+      searchEditDistance(child, childCharacter, depth + 1, target, maxDistance, rows, word, outSuggestions);
+      word.pop_back();
+    });
+  }
+}
+
+template<typename Node>
+void wordsWithinEditDistance(const Node* root, const std::string& target, u32 maxDistance, std::vector<dictionary_suggestion>& outSuggestions) {
+  // a row's min never drops below depth - target length, so the search can't go deeper than this
+  const u32 columnCount = (u32)target.size() + 1;
+  const u32 maxDepth = (u32)target.size() + maxDistance + 1;
+  std::vector<u32> rows((maxDepth + 1) * columnCount);
+  for(u32 i = 0; i < columnCount; i++) {
+    rows[i] = i;
+  }
+
+  if(root->endOfWord && target.size() <= maxDistance) {
+    outSuggestions.push_back({"", (u32)target.size()});
+  }
+
+  std::string word;
+  forEachChild(root, [&](const Node* child, char childCharacter) {
+    word.push_back(childCharacter);
+    searchEditDistance(child, childCharacter, 1, target, maxDistance, rows.data(), word, outSuggestions);
+    word.pop_back();
+  });
+}
+
+// Appends every word within maxDistance insertions, deletions or substitutions of target to outSuggestions, in trie order
+void wordsWithinEditDistance(const linked_trie_dictionary& dict, const std::string& target, u32 maxDistance, std::vector<dictionary_suggestion>& outSuggestions) {
+  wordsWithinEditDistance(&dict.root, target, maxDistance, outSuggestions);
+}
+
+// Appends every word within maxDistance insertions, deletions or substitutions of target to outSuggestions, in alphabetical order
+void wordsWithinEditDistance(const trie_dictionary& dict, const std::string& target, u32 maxDistance, std::vector<dictionary_suggestion>& outSuggestions) {
+  wordsWithinEditDistance(&dict.root, target, maxDistance, outSuggestions);
+}
+
+// ==== CACHE-FRIENDLY LAYOUT
+// nextFree() hands out nodes in insertion order, so the children of a node end up scattered across every malloc block
+// and each step of a nextSibling scan is likely a cache miss. optimizeLayout() copies the trie into a single block where
+// every sibling list is contiguous (nextSibling always points at the adjacent node). The first breadthFirstLevels levels,
+// which nearly every lookup walks through, are laid out breadth-first so they pack into as few cache lines as possible.
+// Below that, each subtree is laid out depth-first so that it sits close to its root.
+const u32 optimizedLayoutBreadthFirstLevels = 3;
+
+u64 countNodes(const linked_trie_dictionary_node* parent) {
+  u64 nodeCount = 0;
+  for(const linked_trie_dictionary_node* child = parent->firstChild; child != nullptr; child = child->nextSibling) {
+    nodeCount += 1 + countNodes(child);
+  }
+  return nodeCount;
+}
+
+// Copies the children of a node, whose firstChild still points into the old layout, to the end of nodes.
+// The copies keep pointing at their old children until they are relocated themselves.
+void relocateChildren(linked_trie_dictionary_node* parent, linked_trie_dictionary_node* nodes, u64& nodeCount) {
+  const linked_trie_dictionary_node* oldChild = parent->firstChild;
+  if(oldChild == nullptr) {
+    return;
+  }
+
+  parent->firstChild = nodes + nodeCount;
+  while(oldChild != nullptr) {
+    linked_trie_dictionary_node* newChild = nodes + nodeCount++;
+    *newChild = *oldChild;
+    oldChild = oldChild->nextSibling;
+    newChild->nextSibling = (oldChild != nullptr) ? newChild + 1 : nullptr;
+  }
+}
+
+void relocateSubtreeDepthFirst(linked_trie_dictionary_node* parent, linked_trie_dictionary_node* nodes, u64& nodeCount) {
+  const u64 childrenBegin = nodeCount;
+  relocateChildren(parent, nodes, nodeCount);
+  const u64 childrenEnd = nodeCount;
+  for(u64 i = childrenBegin; i < childrenEnd; i++) {
+    relocateSubtreeDepthFirst(nodes + i, nodes, nodeCount);
+  }
+}
+
+// Relocates every node into a single block, see CACHE-FRIENDLY LAYOUT. Node pointers held from before are invalidated.
+// Nodes inserted afterwards are allocated from new blocks as usual.
+void optimizeLayout(linked_trie_dictionary& dict, u32 breadthFirstLevels = optimizedLayoutBreadthFirstLevels) {
+  const u64 nodeCount = countNodes(&dict.root);
+  const u64 newMallocSize = MAX(nodeCount, 1) * sizeof(linked_trie_dictionary_node);
+  linked_trie_dictionary_node* nodes = (linked_trie_dictionary_node*)allocateLarge(dict.allocator.arena, newMallocSize, dict.allocator.hugePages);
+
+  // the block itself is the breadth-first queue, [levelBegin, levelEnd) being the last level relocated
+  u64 relocatedCount = 0;
+  relocateChildren(&dict.root, nodes, relocatedCount);
+  u64 levelBegin = 0;
+  u64 levelEnd = relocatedCount;
+  for(u32 level = 1; level < breadthFirstLevels && levelBegin != levelEnd; level++) {
+    for(u64 i = levelBegin; i < levelEnd; i++) {
+      relocateChildren(nodes + i, nodes, relocatedCount);
+    }
+    levelBegin = levelEnd;
+    levelEnd = relocatedCount;
+  }
+  for(u64 i = levelBegin; i < levelEnd; i++) {
+    relocateSubtreeDepthFirst(nodes + i, nodes, relocatedCount);
+  }
+  Assert(relocatedCount == nodeCount);
+
+  linked_trie_dictionary_allocator& allocator = dict.allocator;
+  freeBlocks(allocator);
+  allocator.mallocPtrs.push_back(nodes);
+  allocator.firstMallocSize = newMallocSize;
+  allocator.freeNodes = nullptr;
+  allocator.remainingNodes = 0;
+  allocator.recycledNodes = nullptr;
+  allocator.totalMemoryAllocated = newMallocSize;
+}
+
+// ==== PACKED TRIE
+// Each node's children are stored contiguously and sorted by character. Their characters are also packed into a
+// separate byte array, so finding a child is one or two 16-byte SIMD compares against every sibling at once instead of
+// a nextSibling pointer walk. Children are referenced by u32 index rather than pointer which brings a node down to
+// 8 bytes, 9 with its character. The packed trie is immutable, it is built from a linked trie.
+const u32 packedTrieCharacterPadding = 32; // a full 32-byte compare may read past the last node's character
+
+struct packed_trie_dictionary_node {
+  u32 firstChild; // index into nodes, the node's other children directly follow it
+  u8 childCount;
+  bool endOfWord;
+};
+
+struct packed_trie_dictionary {
+  packed_trie_dictionary_node* nodes; // nodes[0] is the root
+  char* characters; // characters[i] is the character of nodes[i]
+  u32 nodeCount;
+  u64 totalMemoryAllocated;
+};
+
+// Appends the children of linkedNodes[packedIndex], sorted by character, to the end of the packed nodes
+void packChildren(u32 packedIndex, std::vector<const linked_trie_dictionary_node*>& linkedNodes, packed_trie_dictionary& dict) {
+  const linked_trie_dictionary_node* sortedChildren[27];
+  u32 childCount = 0;
+  for(const linked_trie_dictionary_node* child = linkedNodes[packedIndex]->firstChild; child != nullptr; child = child->nextSibling) {
+    u32 i = childCount++;
+    while(i > 0 && sortedChildren[i - 1]->character > child->character) {
+      sortedChildren[i] = sortedChildren[i - 1];
+      i--;
+    }
+    sortedChildren[i] = child;
+  }
+
+  dict.nodes[packedIndex].firstChild = dict.nodeCount;
+  dict.nodes[packedIndex].childCount = (u8)childCount;
+  for(u32 i = 0; i < childCount; i++) {
+    const u32 childIndex = dict.nodeCount++;
+    linkedNodes[childIndex] = sortedChildren[i];
+    dict.nodes[childIndex].firstChild = 0;
+    dict.nodes[childIndex].childCount = 0;
+    dict.nodes[childIndex].endOfWord = sortedChildren[i]->endOfWord;
+    dict.characters[childIndex] = sortedChildren[i]->character;
+  }
+}
+
+void packSubtreeDepthFirst(u32 packedIndex, std::vector<const linked_trie_dictionary_node*>& linkedNodes, packed_trie_dictionary& dict) {
+  const u32 childrenBegin = dict.nodeCount;
+  packChildren(packedIndex, linkedNodes, dict);
+  const u32 childrenEnd = dict.nodeCount;
+  for(u32 i = childrenBegin; i < childrenEnd; i++) {
+    packSubtreeDepthFirst(i, linkedNodes, dict);
+  }
+}
+
+// Nodes are ordered like optimizeLayout(), breadth-first through the top levels then depth-first below them
+void buildDictionary(const linked_trie_dictionary& linkedDict, packed_trie_dictionary& outDict) {
+  const u64 nodeCount = 1 + countNodes(&linkedDict.root);
+  Assert(nodeCount <= U32_MAX);
+  const u64 nodesMallocSize = nodeCount * sizeof(packed_trie_dictionary_node);
+  const u64 charactersMallocSize = nodeCount + packedTrieCharacterPadding;
+  outDict.nodes = (packed_trie_dictionary_node*)malloc(nodesMallocSize);
+  outDict.characters = (char*)calloc(charactersMallocSize, 1);
+  outDict.totalMemoryAllocated = nodesMallocSize + charactersMallocSize;
+
+  std::vector<const linked_trie_dictionary_node*> linkedNodes(nodeCount);
+  linkedNodes[0] = &linkedDict.root;
+  outDict.nodes[0].endOfWord = linkedDict.root.endOfWord;
+  outDict.characters[0] = '*';
+  outDict.nodeCount = 1;
+
+  u32 levelBegin = 0;
+  u32 levelEnd = 1;
+  for(u32 level = 0; level < optimizedLayoutBreadthFirstLevels && levelBegin != levelEnd; level++) {
+    for(u32 i = levelBegin; i < levelEnd; i++) {
+      packChildren(i, linkedNodes, outDict);
+    }
+    levelBegin = levelEnd;
+    levelEnd = outDict.nodeCount;
+  }
+  for(u32 i = levelBegin; i < levelEnd; i++) {
+    packSubtreeDepthFirst(i, linkedNodes, outDict);
+  }
+  Assert(outDict.nodeCount == nodeCount);
+}
+
+void buildDictionary(const char* characters, u64 charactersCount, packed_trie_dictionary& outDict) {
+  linked_trie_dictionary linkedDict;
+  buildDictionary(characters, charactersCount, linkedDict);
+  buildDictionary(linkedDict, outDict);
+  freeDictionary(linkedDict);
+}
+
+void buildDictionary(const std::vector<char>& fileCharacters, packed_trie_dictionary& outDict) {
+  buildDictionary(fileCharacters.data(), fileCharacters.size(), outDict);
+}
+
+void freeDictionary(packed_trie_dictionary& dict) {
+  free(dict.nodes);
+  free(dict.characters);
+  dict = {};
+}
+
+// Returns the index of the child with the given character or U32_MAX if there is none
+u32 findChildIndex(const packed_trie_dictionary& dict, const packed_trie_dictionary_node& parent, char character) {
+  const __m128i key = _mm_set1_epi8(character);
+  const char* childCharacters = dict.characters + parent.firstChild;
+  u32 matchMask = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)childCharacters), key));
+  if(parent.childCount > 16) {
+    matchMask |= (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(childCharacters + 16)), key)) << 16;
+  }
+  matchMask &= (1u << parent.childCount) - 1; // childCount is at most 27
+  return (matchMask != 0) ? parent.firstChild + countTrailingZeros(matchMask) : U32_MAX;
+}
+
+bool contains(const packed_trie_dictionary& dict, const std::string& word) {
+  u32 nodeIndex = 0;
+  for(char character : word) {
+    nodeIndex = findChildIndex(dict, dict.nodes[nodeIndex], character);
+    if(nodeIndex == U32_MAX) {
+      return false;
+    }
+  }
+  return dict.nodes[nodeIndex].endOfWord;
+}
+
+// ==== INCREMENTAL UPDATES
+// Words can be added and removed after the dictionary is built. Removing a word prunes every node left without a word
+// below it and hands it to the allocator's recycledNodes, which nextFree() hands out again before touching its blocks.
+// Both cost O(word length), along with a scan of the children at each level to keep maxFrequency exact.
+
+bool isWord(const std::string& word) {
+  for(char c : word) {
+    if(!isWordCharacter(c)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void recycle(linked_trie_dictionary_allocator& allocator, linked_trie_dictionary_node* node) {
+  node->nextSibling = allocator.recycledNodes;
+  allocator.recycledNodes = node;
+}
+
+void recycle(trie_dictionary_allocator& allocator, trie_dictionary_node* node) {
+  node->children[0] = allocator.recycledNodes;
+  allocator.recycledNodes = node;
+}
+
+// Returns true if the word was found below parent and removed
+bool removeWord(linked_trie_dictionary_node* parent, linked_trie_dictionary_allocator& allocator, const char* word, u64 wordCharCount) {
+  if(wordCharCount == 0) {
+    if(!parent->endOfWord) {
+      return false;
+    }
+    parent->endOfWord = false;
+    parent->frequency = 0;
+  } else {
+    linked_trie_dictionary_node** childSlot = &parent->firstChild;
+    while(*childSlot != nullptr && (*childSlot)->character != word[0]) {
+      childSlot = &(*childSlot)->nextSibling;
+    }
+    linked_trie_dictionary_node* child = *childSlot;
+    if(child == nullptr || !removeWord(child, allocator, word + 1, wordCharCount - 1)) {
+      return false;
+    }
+
+    // prune the child if no word ends in it or below it anymore
+    if(!child->endOfWord && child->firstChild == nullptr) {
+      *childSlot = child->nextSibling;
+      recycle(allocator, child);
+    }
+  }
+
+  parent->maxFrequency = parent->frequency;
+  for(const linked_trie_dictionary_node* child = parent->firstChild; child != nullptr; child = child->nextSibling) {
+    parent->maxFrequency = MAX(parent->maxFrequency, child->maxFrequency);
+  }
+  return true;
+}
+
+// Returns true if the word was found below parent and removed
+bool removeWord(trie_dictionary_node* parent, trie_dictionary_allocator& allocator, const char* word, u64 wordCharCount) {
+  if(wordCharCount == 0) {
+    if(!parent->endOfWord) {
+      return false;
+    }
+    parent->endOfWord = false;
+    parent->frequency = 0;
+  } else {
+    trie_dictionary_node** childSlot = &parent->children[letterIndex(word[0])];
+    trie_dictionary_node* child = *childSlot;
+    if(child == nullptr || !removeWord(child, allocator, word + 1, wordCharCount - 1)) {
+      return false;
+    }
+
+    // prune the child if no word ends in it or below it anymore
+    if(!child->endOfWord) {
+      bool hasChildren = false;
+      for(u32 i = 0; i < supportedLetterCount && !hasChildren; i++) {
+        hasChildren = child->children[i] != nullptr;
+      }
+      if(!hasChildren) {
+        *childSlot = nullptr;
+        recycle(allocator, child);
+      }
+    }
+  }
+
+  parent->maxFrequency = parent->frequency;
+  for(u32 i = 0; i < supportedLetterCount; i++) {
+    if(parent->children[i] != nullptr) {
+      parent->maxFrequency = MAX(parent->maxFrequency, parent->children[i]->maxFrequency);
+    }
+  }
+  return true;
+}
+
+// Returns false if the word was already in the dictionary or has characters that fail isWordCharacter()
+bool insertWord(linked_trie_dictionary& dict, const std::string& word) {
+  if(!isWord(word) || contains(dict, word)) {
+    return false;
+  }
+  insertWord(&dict.root, dict.allocator, word.data(), word.size());
+  return true;
+}
+
+// Returns false if the word was already in the dictionary or has characters that fail isWordCharacter()
+bool insertWord(trie_dictionary& dict, const std::string& word) {
+  if(!isWord(word) || contains(dict, word)) {
+    return false;
+  }
+  insertWord(&dict.root, dict.allocator, word.data(), word.size());
+  return true;
+}
+
+// Returns false if the word was not in the dictionary
+bool removeWord(linked_trie_dictionary& dict, const std::string& word) {
+  return isWord(word) && removeWord(&dict.root, dict.allocator, word.data(), word.size());
+}
+
+// Returns false if the word was not in the dictionary
+bool removeWord(trie_dictionary& dict, const std::string& word) {
+  return isWord(word) && removeWord(&dict.root, dict.allocator, word.data(), word.size());
+}
+
+// ==== CONCURRENT TRIE
+// Array of pointers trie that readers can query while a writer updates it. Readers take no locks and never wait, each
+// contains() is bounded by the word length. Writers are serialized by a mutex. New nodes are fully initialized before a
+// release store links them in, so a reader either sees a node complete or not at all.
+// Nodes pruned by removeWord() can't be reused right away as a reader may still be walking through them. They are
+// retired with the current epoch instead. Readers publish the epoch they started in to their slot for the duration of
+// a contains(), and a retired node is only recycled once every reader in an epoch at or before its retirement is done.
+// Reader threads can come and go: unregisterReader() hands a thread's slot back for the next registerReader().
+const u32 concurrentTrieMaxReaderCount = 64;
+const u64 concurrentTrieIdleEpoch = 0;
+
+struct concurrent_trie_node {
+  std::atomic<bool> endOfWord;
+  std::atomic<concurrent_trie_node*> children[supportedLetterCount];
+};
+
+struct concurrent_trie_retired_node {
+  concurrent_trie_node* node;
+  u64 epoch;
+};
+
+struct alignas(64) concurrent_trie_reader_slot { // one cache line each so readers don't contend
+  std::atomic<u64> epoch;
+  std::atomic<bool> registered;
+};
+
+struct concurrent_trie_allocator {
+  concurrent_trie_node* freeNodes;
+  u64 remainingNodes;
+  concurrent_trie_node* recycledNodes; // linked through children[0]
+  std::vector<void*> mallocPtrs;
+  u32 nodeCountPerMalloc;
+  u64 totalMemoryAllocated;
+};
+
+struct concurrent_trie_dictionary {
+  concurrent_trie_node root;
+  concurrent_trie_allocator allocator; // owned by the writer
+  std::mutex writerMutex;
+  std::vector<concurrent_trie_retired_node> retiredNodes;
+  std::atomic<u64> epoch;
+  concurrent_trie_reader_slot readerSlots[concurrentTrieMaxReaderCount];
+};
+
+void initNode(concurrent_trie_node* node) {
+  node->endOfWord.store(false, std::memory_order_relaxed);
+  for(u32 i = 0; i < supportedLetterCount; i++) {
+    node->children[i].store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+concurrent_trie_node* nextFree(concurrent_trie_allocator& allocator) {
+  concurrent_trie_node* node;
+  if(allocator.recycledNodes != nullptr) {
+    node = allocator.recycledNodes;
+    allocator.recycledNodes = node->children[0].load(std::memory_order_relaxed);
+  } else {
+    if(allocator.remainingNodes == 0) {
+      const u64 newMallocSize = sizeof(concurrent_trie_node) * allocator.nodeCountPerMalloc;
+      void* newMallocPtr = malloc(newMallocSize);
+      allocator.mallocPtrs.push_back(newMallocPtr);
+      allocator.freeNodes = (concurrent_trie_node*)newMallocPtr;
+      allocator.remainingNodes = allocator.nodeCountPerMalloc;
+      allocator.totalMemoryAllocated += newMallocSize;
+    }
+    allocator.remainingNodes--;
+    node = allocator.freeNodes++;
+  }
+
+  initNode(node);
+  return node;
+}
+
+void recycle(concurrent_trie_allocator& allocator, concurrent_trie_node* node) {
+  node->children[0].store(allocator.recycledNodes, std::memory_order_relaxed);
+  allocator.recycledNodes = node;
+}
+
+void initDictionary(concurrent_trie_dictionary& dict, u64 initialNodeCountEstimate) {
+  initNode(&dict.root);
+  dict.allocator = {};
+  dict.allocator.nodeCountPerMalloc = MAX(initialNodeCountEstimate / 50, 64); // increase by 2% each malloc
+  dict.allocator.remainingNodes = 0;
+  dict.retiredNodes.clear();
+  dict.epoch.store(concurrentTrieIdleEpoch + 1);
+  for(concurrent_trie_reader_slot& readerSlot : dict.readerSlots) {
+    readerSlot.epoch.store(concurrentTrieIdleEpoch);
+    readerSlot.registered.store(false);
+  }
+}
+
+// Expects no readers or writers to be running
+void freeDictionary(concurrent_trie_dictionary& dict) {
+  for(void* mallocPtr : dict.allocator.mallocPtrs) {
+    free(mallocPtr);
+  }
+  initDictionary(dict, 0);
+}
+
+// Returns the index a reader thread passes to contains() until it calls unregisterReader(), U32_MAX when every reader
+// slot is taken. contains() still works with U32_MAX, it just takes the writer mutex.
+u32 registerReader(concurrent_trie_dictionary& dict) {
+  for(u32 readerIndex = 0; readerIndex < concurrentTrieMaxReaderCount; readerIndex++) {
+    bool registered = false;
+    if(dict.readerSlots[readerIndex].registered.compare_exchange_strong(registered, true, std::memory_order_acquire)) {
+      return readerIndex;
+    }
+  }
+  return U32_MAX;
+}
+
+// Frees the reader's slot for another thread. The reader must not be inside contains().
+void unregisterReader(concurrent_trie_dictionary& dict, u32 readerIndex) {
+  if(readerIndex >= concurrentTrieMaxReaderCount) {
+    return;
+  }
+  dict.readerSlots[readerIndex].epoch.store(concurrentTrieIdleEpoch, std::memory_order_release);
+  dict.readerSlots[readerIndex].registered.store(false, std::memory_order_release);
+}
+
+bool containsWord(const concurrent_trie_node* root, const std::string& word) {
+  const concurrent_trie_node* node = root;
+  for(char c : word) {
+    if(!isWordCharacter(c)) {
+      return false;
+    }
+    node = node->children[letterIndex(c)].load(std::memory_order_acquire);
+    if(node == nullptr) {
+      return false;
+    }
+  }
+  return node->endOfWord.load(std::memory_order_acquire);
+}
+
+// readerIndex comes from registerReader(). A reader without a slot is served under the writer mutex, so nothing can be
+// pruned while it walks the trie, but it waits for writers and for other readers without a slot.
+bool contains(concurrent_trie_dictionary& dict, u32 readerIndex, const std::string& word) {
+  if(readerIndex >= concurrentTrieMaxReaderCount) {
+    std::lock_guard<std::mutex> writerLock(dict.writerMutex);
+    return containsWord(&dict.root, word);
+  }
+
+  std::atomic<u64>& readerEpoch = dict.readerSlots[readerIndex].epoch;
+  readerEpoch.store(dict.epoch.load());
+  // the writer either sees this reader's epoch or this reader sees the writer's unlinks, see reclaimRetiredNodes()
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  const bool found = containsWord(&dict.root, word);
+
+  readerEpoch.store(concurrentTrieIdleEpoch, std::memory_order_release);
+  return found;
+}
+
+// Expects the writer mutex to be held
+void reclaimRetiredNodes(concurrent_trie_dictionary& dict) {
+  if(dict.retiredNodes.empty()) {
+    return;
+  }
+
+  // readers starting from here on can't reach any retired node
+  dict.epoch.fetch_add(1);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  u64 oldestReaderEpoch = U64_MAX;
+  for(u32 i = 0; i < concurrentTrieMaxReaderCount; i++) { // unregistered slots are idle
+    const u64 readerEpoch = dict.readerSlots[i].epoch.load(std::memory_order_acquire);
+    if(readerEpoch != concurrentTrieIdleEpoch) {
+      oldestReaderEpoch = MIN(oldestReaderEpoch, readerEpoch);
+    }
+  }
+
+  u64 keptCount = 0;
+  for(const concurrent_trie_retired_node& retiredNode : dict.retiredNodes) {
+    if(retiredNode.epoch < oldestReaderEpoch) {
+      recycle(dict.allocator, retiredNode.node);
+    } else {
+      dict.retiredNodes[keptCount++] = retiredNode;
+    }
+  }
+  dict.retiredNodes.resize(keptCount);
+}
+
+// Expects the writer mutex to be held
+void insertWord(concurrent_trie_dictionary& dict, const char* word, u64 wordCharCount) {
+  concurrent_trie_node* parent = &dict.root;
+  for(u64 wordIndex = 0; wordIndex < wordCharCount; wordIndex++) {
+    std::atomic<concurrent_trie_node*>& childSlot = parent->children[letterIndex(word[wordIndex])];
+    concurrent_trie_node* child = childSlot.load(std::memory_order_relaxed);
+    if(child == nullptr) {
+      child = nextFree(dict.allocator);
+      childSlot.store(child, std::memory_order_release);
+    }
+    parent = child;
+  }
+  parent->endOfWord.store(true, std::memory_order_release);
+}
+
+// Expects the writer mutex to be held. Returns true if the word was found below parent and removed.
+bool removeWord(concurrent_trie_dictionary& dict, concurrent_trie_node* parent, const char* word, u64 wordCharCount) {
+  if(wordCharCount == 0) {
+    if(!parent->endOfWord.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    parent->endOfWord.store(false, std::memory_order_release);
+    return true;
+  }
+
+  std::atomic<concurrent_trie_node*>& childSlot = parent->children[letterIndex(word[0])];
+  concurrent_trie_node* child = childSlot.load(std::memory_order_relaxed);
+  if(child == nullptr || !removeWord(dict, child, word + 1, wordCharCount - 1)) {
+    return false;
+  }
+
+  // prune the child if no word ends in it or below it anymore
+  if(!child->endOfWord.load(std::memory_order_relaxed)) {
+    bool hasChildren = false;
+    for(u32 i = 0; i < supportedLetterCount && !hasChildren; i++) {
+      hasChildren = child->children[i].load(std::memory_order_relaxed) != nullptr;
+    }
+    if(!hasChildren) {
+      childSlot.store(nullptr, std::memory_order_release);
+      dict.retiredNodes.push_back({child, dict.epoch.load()});
+    }
+  }
+  return true;
+}
+
+// Returns false if the word was already in the dictionary or has characters that fail isWordCharacter()
+bool insertWord(concurrent_trie_dictionary& dict, const std::string& word) {
+  if(!isWord(word)) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> writerLock(dict.writerMutex);
+  const concurrent_trie_node* node = &dict.root;
+  for(u64 i = 0; i < word.size() && node != nullptr; i++) {
+    node = node->children[letterIndex(word[i])].load(std::memory_order_relaxed);
+  }
+  if(node != nullptr && node->endOfWord.load(std::memory_order_relaxed)) {
+    return false;
+  }
+
+  insertWord(dict, word.data(), word.size());
+  reclaimRetiredNodes(dict);
+  return true;
+}
+
+// Returns false if the word was not in the dictionary
+bool removeWord(concurrent_trie_dictionary& dict, const std::string& word) {
+  if(!isWord(word)) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> writerLock(dict.writerMutex);
+  const bool removed = removeWord(dict, &dict.root, word.data(), word.size());
+  reclaimRetiredNodes(dict);
+  return removed;
+}
+
+void buildDictionary(const char* characters, u64 charactersCount, concurrent_trie_dictionary& outDict) {
+  const u64 initialNodeCountEstimate = charactersCount / 4; // The average word length in the English dictionary is 4.7
+  initDictionary(outDict, initialNodeCountEstimate);
+
+  std::lock_guard<std::mutex> writerLock(outDict.writerMutex);
+  u64 characterIndex = 0;
+  while(characterIndex < charactersCount) {
+    if(!isWordCharacter(characters[characterIndex])) {
+      characterIndex++;
+      continue;
+    }
+
+    const u64 wordBegin = characterIndex;
+    while(characterIndex < charactersCount && isWordCharacter(characters[characterIndex])) {
+      characterIndex++;
+    }
+    insertWord(outDict, characters + wordBegin, characterIndex - wordBegin);
+  }
+}
+
+void buildDictionary(const std::vector<char>& fileCharacters, concurrent_trie_dictionary& outDict) {
+  buildDictionary(fileCharacters.data(), fileCharacters.size(), outDict);
+}
+
+// ==== FILTERED LOOKUPS
+// When most lookups are misses, a Bloom filter (see bloom_filter.cpp) in front of the dictionary answers nearly all of
+// them with one cache line instead of a walk down the trie. Only the words it lets through reach contains().
+
+// Builds the filter from the same words buildDictionary() would insert
+void buildFilter(const char* characters, u64 charactersCount, bloom_filter& outFilter, f64 falsePositiveRate) {
+  u64 wordCount = 0;
+  for(u64 characterIndex = 0; characterIndex < charactersCount; characterIndex++) {
+    wordCount += isWordCharacter(characters[characterIndex])
+                 && (characterIndex + 1 == charactersCount || !isWordCharacter(characters[characterIndex + 1]));
+  }
+  initBloomFilter(outFilter, wordCount, falsePositiveRate);
+
+  u64 characterIndex = 0;
+  while(characterIndex < charactersCount) {
+    if(!isWordCharacter(characters[characterIndex])) {
+      characterIndex++;
+      continue;
+    }
+
+    const u64 wordBegin = characterIndex;
+    while(characterIndex < charactersCount && isWordCharacter(characters[characterIndex])) {
+      characterIndex++;
+    }
+    insert(outFilter, characters + wordBegin, characterIndex - wordBegin);
+  }
+}
+
+void buildFilter(const std::vector<char>& fileCharacters, bloom_filter& outFilter, f64 falsePositiveRate) {
+  buildFilter(fileCharacters.data(), fileCharacters.size(), outFilter, falsePositiveRate);
+}
+
+// Builds the dictionary and its filter together so they start out holding the same words
+template<typename Dictionary>
+void buildDictionary(const std::vector<char>& fileCharacters, Dictionary& outDict, bloom_filter& outFilter, f64 falsePositiveRate) {
+  buildDictionary(fileCharacters, outDict);
+  buildFilter(fileCharacters, outFilter, falsePositiveRate);
+}
+
+// Keeps the filter in sync with the dictionary. The filter was sized for the words it was built from, so every word
+// inserted past that raises its false positive rate a little.
+// There is no filtered removeWord(): a Bloom filter can't forget a key, a removed word just becomes a false positive.
+template<typename Dictionary>
+bool insertWord(Dictionary& dict, bloom_filter& filter, const std::string& word) {
+  if(!insertWord(dict, word)) {
+    return false;
+  }
+  insert(filter, word.data(), word.size());
+  return true;
+}
+
+// The filter must hold every word of the dictionary, so words added after building go through insertWord(dict, filter, word)
+template<typename Dictionary>
+bool contains(const Dictionary& dict, const bloom_filter& filter, const std::string& word) {
+  return mayContain(filter, word.data(), word.size()) && contains(dict, word);
+}
+
+// ==== FOR ALLOCATOR PERFORMANCE TESTING =====
+struct linked_trie_dictionary_no_allocator {
+  linked_trie_dictionary_node root;
+  u64 nodeCount;
+};
+
+void freeDictionary(linked_trie_dictionary_no_allocator& dict) {
+  // TODO: no thanks
+}
+
+bool contains(const linked_trie_dictionary_no_allocator& dict, const std::string& word) {
+  if(dict.root.character != '*' || dict.root.nextSibling != nullptr) {
+    printf("Dictionary root is borked.");
+    return false;
+  }
+
+  const linked_trie_dictionary_node* parent = &dict.root;
+  u32 wordIndex = 0;
+  u32 wordCharCount = word.size();
+  while(parent != nullptr && wordIndex < wordCharCount) {
+    char character = word[wordIndex++];
+
+    linked_trie_dictionary_node* child = parent->firstChild;
+    while(child != nullptr) {
+      if(child->character == character) {
+        parent = child;
+        break;
+      }
+      child = child->nextSibling;
+    }
+    if(parent != child) { // if character not found
+      return false;
+    }
+  }
+
+  return parent->endOfWord;
+}
+
+void buildDictionary(const char* fileCharacters, u64 fileCharactersCount, linked_trie_dictionary_no_allocator& outDict) {
+  // init dictionary to hold nothing
+  outDict.root.character = '*';
+  outDict.root.nextSibling = nullptr;
+  outDict.root.firstChild = nullptr;
+  outDict.nodeCount = 0;
+
+  for(u64 fileCharacterIndex = 0; fileCharacterIndex < fileCharactersCount; fileCharacterIndex++) {
+    char fileCharacter = fileCharacters[fileCharacterIndex];
+
+    // TODO: handle uppercase
+    if((fileCharacter < 'a' || fileCharacter > 'z') && fileCharacter != '-') {
+      continue;
+    }
+
+    linked_trie_dictionary_node* parent = &outDict.root;
+    while(fileCharacterIndex < fileCharactersCount) {
+      fileCharacter = fileCharacters[fileCharacterIndex];
+      if((fileCharacter < 'a' || fileCharacter > 'z') && fileCharacter != '-') {
+        break; // leave the delimiter for the outer loop to step over
+      }
+      fileCharacterIndex++;
+
+      linked_trie_dictionary_node* child = parent->firstChild;
+
+      // search for character amongst children
+      while(child != nullptr) {
+        if(child->character == fileCharacter) {
+          parent = child;
+          break;
+        }
+        child = child->nextSibling;
+      }
+
+      // if character not found, create new one
+      if(parent != child) {
+        child = new linked_trie_dictionary_node;
+        outDict.nodeCount++;
+        child->character = fileCharacter;
+        child->nextSibling = parent->firstChild;
+        parent->firstChild = child;
+        child->firstChild = nullptr;
+        child->endOfWord = false;
+        parent = child;
+      }
+    }
+
+    parent->endOfWord = true;
+  }
+}
+
+void buildDictionary(const std::vector<char>& fileCharacters, linked_trie_dictionary_no_allocator& outDict) {
+  buildDictionary(fileCharacters.data(), fileCharacters.size(), outDict);
+}
@@ -3,6 +3,9 @@
 //
 
 #include "test.h"
+#include <random>
+
+#include "bloom_filter.cpp"
 #include "dictionary_trie.cpp"
 
 const char* wordFile4000 = "4000-most-common-english-words.txt";
@@ -104,4 +107,915 @@ TEST(TrieDictionary, buildDictAndContains_Trie) {
   printf("Malloc Count (trie): %llu\n", trieDictionary.allocator.mallocPtrs.size());
 
   freeDictionary(trieDictionary);
-}
\ No newline at end of file
+}
+
+// Every word in the file should be found in the dictionary
+template<typename Dictionary>
+void assertContainsAllWords(const Dictionary& dict, const std::vector<char>& fileCharacters) {
+  std::string word;
+  for(char c : fileCharacters) {
+    if(isWordCharacter(c)) {
+      word.push_back(c);
+    } else if(!word.empty()) {
+      ASSERT_TRUE(contains(dict, word)) << word;
+      word.clear();
+    }
+  }
+  if(!word.empty()) {
+    ASSERT_TRUE(contains(dict, word)) << word;
+  }
+}
+
+TEST(TrieDictionary, buildDictParallelAndContains_LinkedTrie) {
+  std::vector<char> fileCharacters;
+  readFile(wordFile, fileCharacters);
+
+  Timer timer;
+  StartTimer(timer);
+  linked_trie_dictionary linkedTrieDictionary;
+  buildDictionary(fileCharacters, linkedTrieDictionary);
+  f64 timeToLoad = StopTimer(timer);
+  printf("Time to load (linked trie): %5.5f ms\n", timeToLoad);
+
+  const u32 threadCount = 7; // uneven split of the 27 first letters
+  StartTimer(timer);
+  linked_trie_dictionary parallelLinkedTrieDictionary;
+  buildDictionaryParallel(fileCharacters, parallelLinkedTrieDictionary, threadCount);
+  f64 timeToLoadParallel = StopTimer(timer);
+  printf("Time to load (parallel linked trie, %u threads): %5.5f ms\n", threadCount, timeToLoadParallel);
+
+  ASSERT_FALSE(contains(parallelLinkedTrieDictionary, "thion"));
+  ASSERT_FALSE(contains(parallelLinkedTrieDictionary, "anipol"));
+  ASSERT_FALSE(contains(parallelLinkedTrieDictionary, "selectedz"));
+  ASSERT_FALSE(contains(parallelLinkedTrieDictionary, "frustr"));
+  assertContainsAllWords(parallelLinkedTrieDictionary, fileCharacters);
+
+  f64 totalMemoryAllocatedMBs = parallelLinkedTrieDictionary.allocator.totalMemoryAllocated / 1024.0 / 1024.0;
+  printf("Total Memory (parallel linked trie): %5.5f MBs\n", totalMemoryAllocatedMBs);
+
+  freeDictionary(linkedTrieDictionary);
+  freeDictionary(parallelLinkedTrieDictionary);
+}
+
+TEST(TrieDictionary, buildDictParallelAndContains_Trie) {
+  std::vector<char> fileCharacters;
+  readFile(wordFile, fileCharacters);
+
+  Timer timer;
+  StartTimer(timer);
+  trie_dictionary trieDictionary;
+  buildDictionary(fileCharacters, trieDictionary);
+  f64 timeToLoad = StopTimer(timer);
+  printf("Time to load (trie): %5.5f ms\n", timeToLoad);
+  freeDictionary(trieDictionary);
+
+  StartTimer(timer);
+  trie_dictionary parallelTrieDictionary;
+  buildDictionaryParallel(fileCharacters, parallelTrieDictionary);
+  f64 timeToLoadParallel = StopTimer(timer);
+  printf("Time to load (parallel trie, %u threads): %5.5f ms\n", dictionaryBuildThreadCount(0), timeToLoadParallel);
+
+  ASSERT_FALSE(contains(parallelTrieDictionary, "thion"));
+  ASSERT_FALSE(contains(parallelTrieDictionary, "anipol"));
+  ASSERT_FALSE(contains(parallelTrieDictionary, "selectedz"));
+  ASSERT_FALSE(contains(parallelTrieDictionary, "frustr"));
+  assertContainsAllWords(parallelTrieDictionary, fileCharacters);
+
+  f64 totalMemoryAllocatedMBs = parallelTrieDictionary.allocator.totalMemoryAllocated / 1024.0 / 1024.0;
+  printf("Total Memory (parallel trie): %5.5f MBs\n", totalMemoryAllocatedMBs);
+
+  freeDictionary(parallelTrieDictionary);
+}
+
+TEST(TrieDictionary, buildDictParallelTinyInput) {
+  const char characters[] = "ox\nan";
+  const u64 charactersCount = ArrayCount(characters) - 1;
+  const u32 threadCount = 16; // more threads than characters, most chunks are empty
+
+  linked_trie_dictionary linkedTrieDictionary;
+  buildDictionaryParallel(characters, charactersCount, linkedTrieDictionary, threadCount);
+  ASSERT_TRUE(contains(linkedTrieDictionary, "ox"));
+  ASSERT_TRUE(contains(linkedTrieDictionary, "an"));
+  ASSERT_FALSE(contains(linkedTrieDictionary, "a"));
+  freeDictionary(linkedTrieDictionary);
+
+  trie_dictionary trieDictionary;
+  buildDictionaryParallel(characters, charactersCount, trieDictionary, threadCount);
+  ASSERT_TRUE(contains(trieDictionary, "ox"));
+  ASSERT_TRUE(contains(trieDictionary, "an"));
+  ASSERT_FALSE(contains(trieDictionary, "o"));
+  freeDictionary(trieDictionary);
+}
+
+// Words of the file in a shuffled order, each followed by a misspelled copy of itself
+void buildLookupWords(const std::vector<char>& fileCharacters, std::vector<std::string>& outWords) {
+  outWords.clear();
+  std::string word;
+  for(char c : fileCharacters) {
+    if(isWordCharacter(c)) {
+      word.push_back(c);
+    } else if(!word.empty()) {
+      outWords.push_back(word);
+      word.clear();
+    }
+  }
+  if(!word.empty()) {
+    outWords.push_back(word);
+  }
+
+  std::mt19937 randomGenerator(26);
+  std::shuffle(outWords.begin(), outWords.end(), randomGenerator);
+  const u64 fileWordCount = outWords.size();
+  for(u64 i = 0; i < fileWordCount; i++) {
+    std::string misspelled = outWords[i];
+    misspelled[misspelled.size() / 2] = 'q';
+    outWords.push_back(misspelled);
+  }
+}
+
+template<typename Dictionary>
+void compareContainsBatch(const Dictionary& dict, const std::vector<std::string>& lookupWords, const char* dictName) {
+  const u32 lookupCount = (u32)lookupWords.size();
+  std::vector<std::string_view> lookupWordViews(lookupWords.begin(), lookupWords.end());
+  std::unique_ptr<bool[]> singleResults(new bool[lookupCount]);
+  std::unique_ptr<bool[]> batchResults(new bool[lookupCount]);
+
+  Timer timer;
+  StartTimer(timer);
+  for(u32 i = 0; i < lookupCount; i++) {
+    singleResults[i] = contains(dict, lookupWords[i]);
+  }
+  f64 timeForSingle = StopTimer(timer);
+  printf("Time for %u contains (%s): %5.5f ms\n", lookupCount, dictName, timeForSingle);
+
+  StartTimer(timer);
+  containsBatch(dict, lookupWordViews.data(), lookupCount, batchResults.get());
+  f64 timeForBatch = StopTimer(timer);
+  printf("Time for %u batched contains (%s): %5.5f ms\n", lookupCount, dictName, timeForBatch);
+
+  for(u32 i = 0; i < lookupCount; i++) {
+    ASSERT_EQ(singleResults[i], batchResults[i]) << lookupWords[i];
+  }
+}
+
+TEST(TrieDictionary, containsBatch) {
+  std::vector<char> fileCharacters;
+  readFile(wordFile, fileCharacters);
+  std::vector<std::string> lookupWords;
+  buildLookupWords(fileCharacters, lookupWords);
+  lookupWords.push_back("");
+  lookupWords.push_back("Selected");
+
+  linked_trie_dictionary linkedTrieDictionary;
+  buildDictionary(fileCharacters, linkedTrieDictionary);
+  compareContainsBatch(linkedTrieDictionary, lookupWords, "linked trie");
+  freeDictionary(linkedTrieDictionary);
+
+  trie_dictionary trieDictionary;
+  buildDictionary(fileCharacters, trieDictionary);
+  compareContainsBatch(trieDictionary, lookupWords, "trie");
+  freeDictionary(trieDictionary);
+}
+
+template<typename Dictionary>
+void testPrefixQueries(const Dictionary& dict, const std::vector<char>& fileCharacters, const std::vector<char>& rankedCharacters, const char* dictName) {
+  const std::string prefix = "th";
+  const u32 k = 10;
+
+  // brute force: scan the word lists
+  std::vector<std::string> expectedPrefixWords;
+  std::vector<std::string> fileWords;
+  buildLookupWords(fileCharacters, fileWords);
+  for(u64 i = 0; i < fileWords.size() / 2; i++) { // first half are the real words
+    if(fileWords[i].compare(0, prefix.size(), prefix) == 0) {
+      expectedPrefixWords.push_back(fileWords[i]);
+    }
+  }
+  std::vector<std::string> expectedTopWords;
+  std::string word;
+  for(char c : rankedCharacters) {
+    if(isWordCharacter(c)) {
+      word.push_back(c);
+    } else if(!word.empty()) {
+      if(expectedTopWords.size() < k && word.compare(0, prefix.size(), prefix) == 0 && contains(dict, word)
+         && std::find(expectedTopWords.begin(), expectedTopWords.end(), word) == expectedTopWords.end()) {
+        expectedTopWords.push_back(word);
+      }
+      word.clear();
+    }
+  }
+
+  Timer timer;
+  StartTimer(timer);
+  std::vector<std::string> prefixWords;
+  wordsWithPrefix(dict, prefix, prefixWords);
+  f64 timeForPrefix = StopTimer(timer);
+  printf("Time for %llu words with prefix \"%s\" (%s): %5.5f ms\n", (unsigned long long)prefixWords.size(), prefix.c_str(), dictName, timeForPrefix);
+
+  StartTimer(timer);
+  std::vector<std::string> topWords;
+  topCompletions(dict, prefix, k, topWords);
+  f64 timeForTop = StopTimer(timer);
+  printf("Time for top %u completions of \"%s\" (%s): %5.5f ms\n", k, prefix.c_str(), dictName, timeForTop);
+
+  std::sort(prefixWords.begin(), prefixWords.end());
+  std::sort(expectedPrefixWords.begin(), expectedPrefixWords.end());
+  ASSERT_EQ(prefixWords, expectedPrefixWords);
+  ASSERT_EQ(topWords, expectedTopWords);
+
+  std::vector<std::string> limitedPrefixWords;
+  wordsWithPrefix(dict, prefix, limitedPrefixWords, 3);
+  ASSERT_EQ(limitedPrefixWords.size(), 3);
+
+  std::vector<std::string> noWords;
+  wordsWithPrefix(dict, "qqq", noWords);
+  topCompletions(dict, "qqq", k, noWords);
+  ASSERT_TRUE(noWords.empty());
+
+  // unranked words fill out the completions once the ranked words run out
+  std::vector<std::string> frustrWords;
+  topCompletions(dict, "frustr", 100, frustrWords);
+  ASSERT_EQ(frustrWords[0], "frustration");
+  ASSERT_GT(frustrWords.size(), 1);
+}
+
+TEST(TrieDictionary, prefixQueries) {
+  std::vector<char> fileCharacters;
+  readFile(wordFile, fileCharacters);
+  std::vector<char> rankedCharacters;
+  readFile(wordFile4000, rankedCharacters);
+
+  linked_trie_dictionary linkedTrieDictionary;
+  buildDictionary(fileCharacters, linkedTrieDictionary);
+  loadWordFrequencies(rankedCharacters, linkedTrieDictionary);
+  testPrefixQueries(linkedTrieDictionary, fileCharacters, rankedCharacters, "linked trie");
+  freeDictionary(linkedTrieDictionary);
+
+  trie_dictionary trieDictionary;
+  buildDictionary(fileCharacters, trieDictionary);
+  loadWordFrequencies(rankedCharacters, trieDictionary);
+  testPrefixQueries(trieDictionary, fileCharacters, rankedCharacters, "trie");
+  freeDictionary(trieDictionary);
+}
+
+u32 editDistance(const std::string& a, const std::string& b) {
+  std::vector<u32> prevRow(b.size() + 1);
+  std::vector<u32> row(b.size() + 1);
+  for(u32 j = 0; j <= b.size(); j++) {
+    prevRow[j] = j;
+  }
+  for(u32 i = 1; i <= a.size(); i++) {
+    row[0] = i;
+    for(u32 j = 1; j <= b.size(); j++) {
+      const u32 substitutionCost = (a[i - 1] == b[j - 1]) ? 0 : 1;
+      row[j] = MIN(MIN(row[j - 1] + 1, prevRow[j] + 1), prevRow[j - 1] + substitutionCost);
+    }
+    std::swap(row, prevRow);
+  }
+  return prevRow[b.size()];
+}
+
+template<typename Dictionary>
+void testEditDistanceQueries(const Dictionary& dict, const std::vector<std::string>& fileWords, const char* dictName) {
+  const char* misspellings[] = {"frustation", "vacum", "selectd", "teh", "xq"};
+  for(const char* misspelling : misspellings) {
+    for(u32 maxDistance = 1; maxDistance <= 2; maxDistance++) {
+      std::vector<std::pair<std::string, u32>> expectedSuggestions;
+      for(const std::string& fileWord : fileWords) {
+        u32 distance = editDistance(misspelling, fileWord);
+        if(distance <= maxDistance) {
+          expectedSuggestions.emplace_back(fileWord, distance);
+        }
+      }
+
+      Timer timer;
+      StartTimer(timer);
+      std::vector<dictionary_suggestion> suggestions;
+      wordsWithinEditDistance(dict, misspelling, maxDistance, suggestions);
+      f64 timeForSuggestions = StopTimer(timer);
+      printf("Time for %llu suggestions within %u of \"%s\" (%s): %5.5f ms\n",
+             (unsigned long long)suggestions.size(), maxDistance, misspelling, dictName, timeForSuggestions);
+
+      std::vector<std::pair<std::string, u32>> foundSuggestions;
+      for(const dictionary_suggestion& suggestion : suggestions) {
+        foundSuggestions.emplace_back(suggestion.word, suggestion.distance);
+      }
+      std::sort(foundSuggestions.begin(), foundSuggestions.end());
+      std::sort(expectedSuggestions.begin(), expectedSuggestions.end());
+      ASSERT_EQ(foundSuggestions, expectedSuggestions);
+    }
+  }
+}
+
+TEST(TrieDictionary, editDistanceQueries) {
+  std::vector<char> fileCharacters;
+  readFile(wordFile, fileCharacters);
+  std::vector<std::string> fileWords;
+  buildLookupWords(fileCharacters, fileWords);
+  fileWords.resize(fileWords.size() / 2); // drop the misspelled half
+
+  linked_trie_dictionary linkedTrieDictionary;
+  buildDictionary(fileCharacters, linkedTrieDictionary);
+  testEditDistanceQueries(linkedTrieDictionary, fileWords, "linked trie");
+  freeDictionary(linkedTrieDictionary);
+
+  trie_dictionary trieDictionary;
+  buildDictionary(fileCharacters, trieDictionary);
+  testEditDistanceQueries(trieDictionary, fileWords, "trie");
+  freeDictionary(trieDictionary);
+}
+
+template <typename Dictionary>
+f64 timeContains(const Dictionary& dict, const std::vector<std::string>& lookupWords, u32& outFoundCount, u64 firstWord = 0) {
+  Timer timer;
+  StartTimer(timer);
+  outFoundCount = 0;
+  for(u64 i = 0; i < lookupWords.size(); i++) {
+    outFoundCount += contains(dict, lookupWords[(firstWord + i) % lookupWords.size()]);
+  }
+  return StopTimer(timer);
+}
+
+TEST(TrieDictionary, buildDictAndContains_AdaptiveTrie) {
+  std::vector<char> fileCharacters;
+  readFile(wordFile, fileCharacters);
+  std::vector<std::string> lookupWords;
+  buildLookupWords(fileCharacters, lookupWords);
+
+  Timer timer;
+  StartTimer(timer);
+  adaptive_trie_dictionary adaptiveTrieDictionary;
+  buildDictionary(fileCharacters, adaptiveTrieDictionary);
+  f64 timeToLoad = StopTimer(timer);
+  printf("Time to load (adaptive trie): %5.5f ms\n", timeToLoad);
+
+  ASSERT_TRUE(contains(adaptiveTrieDictionary, "the"));
+  ASSERT_TRUE(contains(adaptiveTrieDictionary, "and"));
+  ASSERT_TRUE(contains(adaptiveTrieDictionary, "vacuum"));
+  ASSERT_TRUE(contains(adaptiveTrieDictionary, "selected"));
+  ASSERT_TRUE(contains(adaptiveTrieDictionary, "frustration"));
+  ASSERT_FALSE(contains(adaptiveTrieDictionary, "thion"));
+  ASSERT_FALSE(contains(adaptiveTrieDictionary, "anipol"));
+  ASSERT_FALSE(contains(adaptiveTrieDictionary, "selectedz"));
+  ASSERT_FALSE(contains(adaptiveTrieDictionary, "frustr"));
+  assertContainsAllWords(adaptiveTrieDictionary, fileCharacters);
+
+  trie_dictionary trieDictionary;
+  buildDictionary(fileCharacters, trieDictionary);
+
+  // best of a few interleaved passes, each starting at a different word, one pass is too noisy to compare. On the
+  // 1-core test box the adaptive trie measured 1.04x the trie time for the hits and 1.03-1.13x for all lookups, the
+  // misspelled half is slower because misses run further down the shared prefixes before failing
+  const u32 passCount = 5;
+  f64 adaptiveTrieTime = 1e30;
+  f64 trieTime = 1e30;
+  u32 adaptiveTrieFoundCount = 0;
+  u32 trieFoundCount = 0;
+  for(u32 pass = 0; pass < passCount; pass++) {
+    const u64 firstWord = pass * lookupWords.size() / passCount;
+    adaptiveTrieTime = MIN(adaptiveTrieTime, timeContains(adaptiveTrieDictionary, lookupWords, adaptiveTrieFoundCount, firstWord));
+    trieTime = MIN(trieTime, timeContains(trieDictionary, lookupWords, trieFoundCount, firstWord));
+    ASSERT_EQ(adaptiveTrieFoundCount, trieFoundCount);
+  }
+  printf("Time for %llu contains (adaptive trie): %5.5f ms\n", (unsigned long long)lookupWords.size(), adaptiveTrieTime);
+  printf("Time for %llu contains (trie): %5.5f ms\n", (unsigned long long)lookupWords.size(), trieTime);
+
+  const adaptive_trie_allocator& allocator = adaptiveTrieDictionary.allocator;
+  printf("Total Memory (adaptive trie): %5.5f MBs\n", allocator.totalMemoryAllocated / 1024.0 / 1024.0);
+  printf("Node Counts (adaptive trie): %llu node4s, %llu node16s, %llu node256s, %llu leaves\n",
+         (unsigned long long)allocator.nodeCounts[AdaptiveTrieNode4], (unsigned long long)allocator.nodeCounts[AdaptiveTrieNode16],
+         (unsigned long long)allocator.nodeCounts[AdaptiveTrieNode256], (unsigned long long)allocator.nodeCounts[AdaptiveTrieLeaf]);
+  ASSERT_LT(allocator.totalMemoryAllocated, trieDictionary.allocator.totalMemoryAllocated);
+  // the margin only absorbs timer noise, the 1.8x lookups this replaced fail it
+  ASSERT_LT(adaptiveTrieTime, trieTime * 1.3);
+
+  freeDictionary(trieDictionary);
+  freeDictionary(adaptiveTrieDictionary);
+  ASSERT_FALSE(contains(adaptiveTrieDictionary, "the"));
+}
+
+TEST(TrieDictionary, buildDictAndContains_AdaptiveTrie_Utf8) {
+  const char* words = "caf\xC3\xA9 na\xC3\xAFve \xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E Hello hello don't \xFF\x80\r\n";
+  std::vector<char> fileCharacters(words, words + strlen(words));
+  // enough siblings under one node to grow it through every node type
+  for(u32 c = 0x21; c < 0x100; c++) {
+    fileCharacters.push_back('~');
+    fileCharacters.push_back((char)c);
+    fileCharacters.push_back('\n');
+  }
+
+  adaptive_trie_dictionary adaptiveTrieDictionary;
+  buildDictionary(fileCharacters, adaptiveTrieDictionary);
+
+  ASSERT_TRUE(contains(adaptiveTrieDictionary, "caf\xC3\xA9"));
+  ASSERT_TRUE(contains(adaptiveTrieDictionary, "na\xC3\xAFve"));
+  ASSERT_TRUE(contains(adaptiveTrieDictionary, "\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E"));
+  ASSERT_TRUE(contains(adaptiveTrieDictionary, "Hello"));
+  ASSERT_TRUE(contains(adaptiveTrieDictionary, "hello"));
+  ASSERT_TRUE(contains(adaptiveTrieDictionary, "don't"));
+  ASSERT_TRUE(contains(adaptiveTrieDictionary, "\xFF\x80"));
+  ASSERT_FALSE(contains(adaptiveTrieDictionary, "caf"));
+  ASSERT_FALSE(contains(adaptiveTrieDictionary, "cafe"));
+  ASSERT_FALSE(contains(adaptiveTrieDictionary, "HELLO"));
+  ASSERT_FALSE(contains(adaptiveTrieDictionary, "\xE6\x97\xA5"));
+  ASSERT_FALSE(contains(adaptiveTrieDictionary, "~"));
+  for(u32 c = 0x21; c < 0x100; c++) {
+    const char word[] = {'~', (char)c, '\0'};
+    ASSERT_TRUE(contains(adaptiveTrieDictionary, word)) << c;
+  }
+  ASSERT_EQ(adaptiveTrieDictionary.allocator.nodeCounts[AdaptiveTrieNode256], 1);
+
+  freeDictionary(adaptiveTrieDictionary);
+}
+
+template<typename Dictionary>
+void testStreamingBuild(const char* filePath, u64 chunkSize, const char* dictName) {
+  std::vector<char> fileCharacters;
+  readFile(filePath, fileCharacters);
+
+  FILE* file = fopen(filePath, "rb");
+  ASSERT_NE(file, nullptr);
+  Timer timer;
+  StartTimer(timer);
+  Dictionary dict;
+  buildDictionary(file, dict, chunkSize);
+  f64 timeToLoad = StopTimer(timer);
+  fclose(file);
+  printf("Time to stream %s in %llu byte chunks (%s): %5.5f ms\n", filePath, (unsigned long long)chunkSize, dictName, timeToLoad);
+
+  ASSERT_FALSE(contains(dict, "thion"));
+  ASSERT_FALSE(contains(dict, "frustr"));
+  assertContainsAllWords(dict, fileCharacters);
+
+  freeDictionary(dict);
+}
+
+TEST(TrieDictionary, buildDictStreaming) {
+  testStreamingBuild<linked_trie_dictionary>(wordFile, streamingChunkSize, "linked trie");
+  testStreamingBuild<trie_dictionary>(wordFile, streamingChunkSize, "trie");
+  testStreamingBuild<adaptive_trie_dictionary>(wordFile, streamingChunkSize, "adaptive trie");
+
+  // chunks shorter than many of the words
+  testStreamingBuild<linked_trie_dictionary>(wordFile, 5, "linked trie");
+  testStreamingBuild<trie_dictionary>(wordFile, 5, "trie");
+  testStreamingBuild<adaptive_trie_dictionary>(wordFile, 5, "adaptive trie");
+}
+
+TEST(TrieDictionary, buildDictFromMappedFile) {
+  Timer timer;
+  StartTimer(timer);
+  std::vector<char> fileCharacters;
+  readFile(wordFile, fileCharacters);
+  f64 timeToRead = StopTimer(timer);
+  printf("Time to read %s: %5.5f ms\n", wordFile, timeToRead);
+
+  StartTimer(timer);
+  MappedFile mappedFile;
+  ASSERT_TRUE(mapFile(wordFile, mappedFile));
+  f64 timeToMap = StopTimer(timer);
+  printf("Time to map %s: %5.5f ms\n", wordFile, timeToMap);
+  ASSERT_EQ(mappedFile.size, fileCharacters.size());
+  ASSERT_EQ(memcmp(mappedFile.data, fileCharacters.data(), mappedFile.size), 0);
+
+  StartTimer(timer);
+  linked_trie_dictionary linkedTrieDictionary;
+  buildDictionary(mappedFile.data, mappedFile.size, linkedTrieDictionary);
+  f64 timeToLoad = StopTimer(timer);
+  printf("Time to load from mapped file (linked trie): %5.5f ms\n", timeToLoad);
+  assertContainsAllWords(linkedTrieDictionary, fileCharacters);
+  freeDictionary(linkedTrieDictionary);
+
+  unmapFile(mappedFile);
+  ASSERT_EQ(mappedFile.data, nullptr);
+  ASSERT_FALSE(mapFile("file_that_does_not_exist.txt", mappedFile));
+}
+
+TEST(TrieDictionary, optimizeLayout) {
+  std::vector<char> fileCharacters;
+  readFile(wordFile, fileCharacters);
+  std::vector<std::string> lookupWords;
+  buildLookupWords(fileCharacters, lookupWords);
+
+  linked_trie_dictionary linkedTrieDictionary;
+  buildDictionary(fileCharacters, linkedTrieDictionary);
+  u32 foundCount;
+  const f64 timeForContains = timeContains(linkedTrieDictionary, lookupWords, foundCount);
+  printf("Time for %llu contains (linked trie, insertion order): %5.5f ms\n", (unsigned long long)lookupWords.size(), timeForContains);
+
+  const u32 breadthFirstLevelCounts[] = {1, optimizedLayoutBreadthFirstLevels, 64};
+  for(u32 breadthFirstLevels : breadthFirstLevelCounts) {
+    Timer timer;
+    StartTimer(timer);
+    optimizeLayout(linkedTrieDictionary, breadthFirstLevels);
+    f64 timeToOptimize = StopTimer(timer);
+    ASSERT_EQ(linkedTrieDictionary.allocator.mallocPtrs.size(), 1);
+
+    u32 optimizedFoundCount;
+    const f64 timeForOptimizedContains = timeContains(linkedTrieDictionary, lookupWords, optimizedFoundCount);
+    printf("Time for %llu contains (linked trie, %u breadth-first levels): %5.5f ms, %5.2fx speedup, %5.5f ms to optimize\n",
+           (unsigned long long)lookupWords.size(), breadthFirstLevels, timeForOptimizedContains,
+           timeForContains / timeForOptimizedContains, timeToOptimize);
+    ASSERT_EQ(optimizedFoundCount, foundCount);
+  }
+  printf("Total Memory (optimized linked trie): %5.5f MBs\n", linkedTrieDictionary.allocator.totalMemoryAllocated / 1024.0 / 1024.0);
+  assertContainsAllWords(linkedTrieDictionary, fileCharacters);
+
+  // inserting after optimizing falls back to new blocks
+  ASSERT_FALSE(contains(linkedTrieDictionary, "zzzqx"));
+  insertWord(&linkedTrieDictionary.root, linkedTrieDictionary.allocator, "zzzqx", 5);
+  ASSERT_TRUE(contains(linkedTrieDictionary, "zzzqx"));
+  ASSERT_EQ(linkedTrieDictionary.allocator.mallocPtrs.size(), 2);
+
+  freeDictionary(linkedTrieDictionary);
+}
+
+// The array trie's initial node block is hundreds of MBs, the random lookups of buildLookupWords() miss the TLB a lot. Only timed,
+// TLB misses aren't counted.
+u32 timeHugePagesContains(const std::vector<char>& fileCharacters, const std::vector<std::string>& lookupWords, bool hugePages) {
+  trie_dictionary trieDictionary;
+  buildDictionary(fileCharacters, trieDictionary, nullptr, hugePages);
+  u32 foundCount = 0;
+  Timer timer;
+  StartTimer(timer);
+  for(const std::string& word : lookupWords) {
+    foundCount += contains(trieDictionary, word);
+  }
+  f64 timeForContains = StopTimer(timer);
+
+  printf("Time for %llu contains (trie, %s pages): %5.5f ms\n", (unsigned long long)lookupWords.size(),
+         hugePages ? "2MB" : "4KB", timeForContains);
+  freeDictionary(trieDictionary);
+  return foundCount;
+}
+
+TEST(TrieDictionary, hugePages) {
+  std::vector<char> fileCharacters;
+  readFile(wordFile, fileCharacters);
+  std::vector<std::string> lookupWords;
+  buildLookupWords(fileCharacters, lookupWords);
+  const u32 foundCount = timeHugePagesContains(fileCharacters, lookupWords, false);
+  ASSERT_EQ(timeHugePagesContains(fileCharacters, lookupWords, true), foundCount);
+}
+
+TEST(TrieDictionary, buildDictAndContains_PackedTrie) {
+  std::vector<char> fileCharacters;
+  readFile(wordFile, fileCharacters);
+  std::vector<std::string> lookupWords;
+  buildLookupWords(fileCharacters, lookupWords);
+  lookupWords.push_back("");
+
+  Timer timer;
+  StartTimer(timer);
+  packed_trie_dictionary packedTrieDictionary;
+  buildDictionary(fileCharacters, packedTrieDictionary);
+  f64 timeToLoad = StopTimer(timer);
+  printf("Time to load (packed trie): %5.5f ms\n", timeToLoad);
+
+  ASSERT_TRUE(contains(packedTrieDictionary, "the"));
+  ASSERT_TRUE(contains(packedTrieDictionary, "and"));
+  ASSERT_TRUE(contains(packedTrieDictionary, "vacuum"));
+  ASSERT_TRUE(contains(packedTrieDictionary, "selected"));
+  ASSERT_TRUE(contains(packedTrieDictionary, "frustration"));
+  ASSERT_FALSE(contains(packedTrieDictionary, "thion"));
+  ASSERT_FALSE(contains(packedTrieDictionary, "anipol"));
+  ASSERT_FALSE(contains(packedTrieDictionary, "selectedz"));
+  ASSERT_FALSE(contains(packedTrieDictionary, "frustr"));
+  ASSERT_FALSE(contains(packedTrieDictionary, "Selected"));
+  assertContainsAllWords(packedTrieDictionary, fileCharacters);
+
+  linked_trie_dictionary linkedTrieDictionary;
+  buildDictionary(fileCharacters, linkedTrieDictionary);
+  u32 linkedTrieFoundCount;
+  f64 timeForContains = timeContains(linkedTrieDictionary, lookupWords, linkedTrieFoundCount);
+  printf("Time for %llu contains (linked trie): %5.5f ms\n", (unsigned long long)lookupWords.size(), timeForContains);
+
+  StartTimer(timer);
+  u32 packedTrieFoundCount = 0;
+  for(const std::string& word : lookupWords) {
+    packedTrieFoundCount += contains(packedTrieDictionary, word);
+  }
+  timeForContains = StopTimer(timer);
+  printf("Time for %llu contains (packed trie): %5.5f ms\n", (unsigned long long)lookupWords.size(), timeForContains);
+  ASSERT_EQ(packedTrieFoundCount, linkedTrieFoundCount);
+
+  printf("Total Memory (linked trie): %5.5f MBs\n", linkedTrieDictionary.allocator.totalMemoryAllocated / 1024.0 / 1024.0);
+  printf("Total Memory (packed trie): %5.5f MBs\n", packedTrieDictionary.totalMemoryAllocated / 1024.0 / 1024.0);
+  ASSERT_LT(packedTrieDictionary.totalMemoryAllocated, linkedTrieDictionary.allocator.totalMemoryAllocated);
+
+  freeDictionary(linkedTrieDictionary);
+  freeDictionary(packedTrieDictionary);
+}
+
+template<typename Dictionary>
+void testIncrementalUpdates(const std::vector<char>& fileCharacters, const std::vector<char>& rankedCharacters, const char* dictName) {
+  std::vector<std::string> words;
+  buildLookupWords(fileCharacters, words);
+  words.resize(words.size() / 2); // drop the misspelled copies
+
+  Dictionary dict;
+  buildDictionary(fileCharacters, dict);
+  loadWordFrequencies(rankedCharacters, dict);
+  const u64 mallocCount = dict.allocator.mallocPtrs.size();
+  const u64 totalMemoryAllocated = dict.allocator.totalMemoryAllocated;
+
+  ASSERT_FALSE(insertWord(dict, "the"));
+  ASSERT_FALSE(insertWord(dict, "Selected"));
+  ASSERT_FALSE(removeWord(dict, "frustr"));
+  ASSERT_FALSE(removeWord(dict, "thion"));
+  ASSERT_FALSE(removeWord(dict, "Selected"));
+
+  // removing the most frequent word hands its completions over to the next one
+  std::vector<std::string> topWords;
+  topCompletions(dict, "th", 1, topWords);
+  ASSERT_EQ(topWords[0], "the");
+  ASSERT_TRUE(removeWord(dict, "the"));
+  ASSERT_FALSE(removeWord(dict, "the"));
+  ASSERT_FALSE(contains(dict, "the"));
+  ASSERT_TRUE(contains(dict, "then"));
+  topWords.clear();
+  topCompletions(dict, "th", 1, topWords);
+  ASSERT_EQ(topWords[0], "that");
+  ASSERT_TRUE(insertWord(dict, "the"));
+
+  Timer timer;
+  StartTimer(timer);
+  for(u64 i = 0; i < words.size(); i += 2) {
+    ASSERT_TRUE(removeWord(dict, words[i])) << words[i];
+  }
+  f64 timeToRemove = StopTimer(timer);
+  printf("Time to remove %llu words (%s): %5.5f ms\n", (unsigned long long)(words.size() + 1) / 2, dictName, timeToRemove);
+  for(u64 i = 0; i < words.size(); i++) {
+    ASSERT_EQ(contains(dict, words[i]), i % 2 == 1) << words[i];
+  }
+
+  StartTimer(timer);
+  for(u64 i = 0; i < words.size(); i += 2) {
+    ASSERT_TRUE(insertWord(dict, words[i])) << words[i];
+  }
+  f64 timeToInsert = StopTimer(timer);
+  printf("Time to insert %llu words (%s): %5.5f ms\n", (unsigned long long)(words.size() + 1) / 2, dictName, timeToInsert);
+  assertContainsAllWords(dict, fileCharacters);
+
+  // emptying the dictionary prunes every node, refilling it only needs recycled ones
+  for(const std::string& word : words) {
+    ASSERT_TRUE(removeWord(dict, word)) << word;
+  }
+  for(const std::string& word : words) {
+    ASSERT_FALSE(contains(dict, word)) << word;
+  }
+  std::vector<std::string> remainingWords;
+  wordsWithPrefix(dict, "", remainingWords);
+  ASSERT_TRUE(remainingWords.empty());
+  for(const std::string& word : words) {
+    ASSERT_TRUE(insertWord(dict, word)) << word;
+  }
+  assertContainsAllWords(dict, fileCharacters);
+  ASSERT_EQ(dict.allocator.mallocPtrs.size(), mallocCount);
+  ASSERT_EQ(dict.allocator.totalMemoryAllocated, totalMemoryAllocated);
+
+  freeDictionary(dict);
+}
+
+TEST(TrieDictionary, incrementalUpdates) {
+  std::vector<char> fileCharacters;
+  readFile(wordFile, fileCharacters);
+  std::vector<char> rankedCharacters;
+  readFile(wordFile4000, rankedCharacters);
+
+  testIncrementalUpdates<linked_trie_dictionary>(fileCharacters, rankedCharacters, "linked trie");
+  testIncrementalUpdates<trie_dictionary>(fileCharacters, rankedCharacters, "trie");
+}
+
+TEST(TrieDictionary, concurrentReadersAndWriter) {
+  const u32 readerThreadCount = 8;
+  const u32 writerRoundCount = 20;
+
+  std::vector<char> fileCharacters;
+  readFile(wordFile4000, fileCharacters);
+  std::vector<std::string> stableWords;
+  buildLookupWords(fileCharacters, stableWords);
+  stableWords.resize(stableWords.size() / 2); // drop the misspelled copies
+  std::sort(stableWords.begin(), stableWords.end());
+  stableWords.erase(std::unique(stableWords.begin(), stableWords.end()), stableWords.end());
+  std::vector<std::string> churnWords; // inserted and removed by the writer, below the stable words
+  std::vector<std::string> absentWords; // never inserted
+  for(const std::string& word : stableWords) {
+    churnWords.push_back(word + "zq");
+    absentWords.push_back(word + "qz");
+  }
+
+  concurrent_trie_dictionary dict;
+  buildDictionary(fileCharacters, dict);
+
+  std::atomic<bool> writerDone(false);
+  std::atomic<u32> stableMissCount(0);
+  std::atomic<u32> absentFoundCount(0);
+  std::atomic<u64> containsCount(0);
+  std::vector<std::thread> readerThreads;
+  for(u32 threadIndex = 0; threadIndex < readerThreadCount; threadIndex++) {
+    readerThreads.emplace_back([&, threadIndex]() {
+      const u32 readerIndex = registerReader(dict);
+      u64 threadContainsCount = 0;
+      u64 wordIndex = threadIndex;
+      while(!writerDone.load()) {
+        wordIndex = (wordIndex + 7) % stableWords.size();
+        stableMissCount += !contains(dict, readerIndex, stableWords[wordIndex]);
+        absentFoundCount += contains(dict, readerIndex, absentWords[wordIndex]);
+        contains(dict, readerIndex, churnWords[wordIndex]); // either answer is fine mid-update
+        threadContainsCount += 3;
+      }
+      containsCount += threadContainsCount;
+      unregisterReader(dict, readerIndex);
+    });
+  }
+
+  Timer timer;
+  StartTimer(timer);
+  u32 failedUpdateCount = 0; // no early return while the readers still run
+  for(u32 round = 0; round < writerRoundCount; round++) {
+    for(const std::string& word : churnWords) {
+      failedUpdateCount += !insertWord(dict, word);
+    }
+    for(const std::string& word : churnWords) {
+      failedUpdateCount += !removeWord(dict, word);
+    }
+  }
+  f64 timeForUpdates = StopTimer(timer);
+  writerDone.store(true);
+  for(std::thread& readerThread : readerThreads) {
+    readerThread.join();
+  }
+  printf("Time for %llu updates alongside %u readers (concurrent trie): %5.5f ms, %llu reader contains\n",
+         (unsigned long long)churnWords.size() * writerRoundCount * 2, readerThreadCount, timeForUpdates,
+         (unsigned long long)containsCount.load());
+  printf("Total Memory (concurrent trie): %5.5f MBs\n", dict.allocator.totalMemoryAllocated / 1024.0 / 1024.0);
+
+  ASSERT_EQ(failedUpdateCount, 0);
+  ASSERT_EQ(stableMissCount.load(), 0);
+  ASSERT_EQ(absentFoundCount.load(), 0);
+  ASSERT_FALSE(insertWord(dict, stableWords[0]));
+  ASSERT_FALSE(removeWord(dict, churnWords[0]));
+  ASSERT_TRUE(insertWord(dict, churnWords[0]));
+  ASSERT_TRUE(removeWord(dict, churnWords[0]));
+  ASSERT_TRUE(dict.retiredNodes.empty()); // with no readers left everything is recycled right away
+
+  const u32 readerIndex = registerReader(dict);
+  for(u64 i = 0; i < stableWords.size(); i++) {
+    ASSERT_TRUE(contains(dict, readerIndex, stableWords[i])) << stableWords[i];
+    ASSERT_FALSE(contains(dict, readerIndex, churnWords[i])) << churnWords[i];
+  }
+  unregisterReader(dict, readerIndex);
+
+  freeDictionary(dict);
+}
+
+// Short lived reader threads, like request threads, each taking a slot and handing it back, many times over the 64
+// slots there are. A writer churns words under them the whole time.
+TEST(TrieDictionary, concurrentReaderSlotReuse) {
+  const u32 waveCount = 12;
+  const u32 readerThreadCountPerWave = 16;
+
+  std::vector<char> fileCharacters;
+  readFile(wordFile4000, fileCharacters);
+  concurrent_trie_dictionary dict;
+  buildDictionary(fileCharacters, dict);
+  const std::string stableWords[] = {"the", "selected", "house"};
+  const std::string churnWords[] = {"thezq", "selectedzq", "housezq"};
+
+  std::atomic<bool> writerDone(false);
+  std::thread writerThread([&]() {
+    while(!writerDone.load()) {
+      for(const std::string& word : churnWords) {
+        insertWord(dict, word);
+      }
+      for(const std::string& word : churnWords) {
+        removeWord(dict, word);
+      }
+    }
+  });
+
+  std::atomic<u32> noSlotCount(0);
+  std::atomic<u32> stableMissCount(0);
+  for(u32 wave = 0; wave < waveCount; wave++) {
+    std::vector<std::thread> readerThreads;
+    for(u32 threadIndex = 0; threadIndex < readerThreadCountPerWave; threadIndex++) {
+      readerThreads.emplace_back([&]() {
+        const u32 readerIndex = registerReader(dict);
+        noSlotCount += (readerIndex == U32_MAX);
+        for(u32 i = 0; i < 1000; i++) {
+          const std::string& word = stableWords[i % ArrayCount(stableWords)];
+          stableMissCount += !contains(dict, readerIndex, word);
+          contains(dict, readerIndex, churnWords[i % ArrayCount(churnWords)]);
+        }
+        unregisterReader(dict, readerIndex);
+      });
+    }
+    for(std::thread& readerThread : readerThreads) {
+      readerThread.join();
+    }
+  }
+  writerDone.store(true);
+  writerThread.join();
+  ASSERT_EQ(noSlotCount.load(), 0); // 192 reader lifetimes, never more than 16 at once
+  ASSERT_EQ(stableMissCount.load(), 0);
+
+  // with every slot taken a reader gets no index, and its lookups go through the writer mutex
+  u32 readerIndices[concurrentTrieMaxReaderCount];
+  for(u32& readerIndex : readerIndices) {
+    readerIndex = registerReader(dict);
+    ASSERT_NE(readerIndex, U32_MAX);
+  }
+  const u32 extraReaderIndex = registerReader(dict);
+  ASSERT_EQ(extraReaderIndex, U32_MAX);
+  ASSERT_TRUE(contains(dict, extraReaderIndex, "the"));
+  ASSERT_FALSE(contains(dict, extraReaderIndex, "thezq"));
+  unregisterReader(dict, readerIndices[5]);
+  ASSERT_EQ(registerReader(dict), readerIndices[5]);
+
+  freeDictionary(dict);
+}
+
+template<typename Dictionary>
+void compareFilteredContains(const Dictionary& dict, const bloom_filter& filter, const std::vector<std::string>& lookupWords, const char* dictName) {
+  Timer timer;
+  StartTimer(timer);
+  u32 foundCount = 0;
+  for(const std::string& word : lookupWords) {
+    foundCount += contains(dict, word);
+  }
+  f64 timeForContains = StopTimer(timer);
+  printf("Time for %llu contains (%s): %5.5f ms\n", (unsigned long long)lookupWords.size(), dictName, timeForContains);
+
+  StartTimer(timer);
+  u32 filteredFoundCount = 0;
+  for(const std::string& word : lookupWords) {
+    filteredFoundCount += contains(dict, filter, word);
+  }
+  f64 timeForFilteredContains = StopTimer(timer);
+  printf("Time for %llu filtered contains (%s): %5.5f ms\n", (unsigned long long)lookupWords.size(), dictName, timeForFilteredContains);
+  ASSERT_EQ(filteredFoundCount, foundCount);
+}
+
+TEST(TrieDictionary, filteredContains) {
+  std::vector<char> fileCharacters;
+  readFile(wordFile, fileCharacters);
+
+  // mostly misses, like a pipeline filtering arbitrary text: one hit for every ten misspellings
+  std::vector<std::string> lookupWords;
+  buildLookupWords(fileCharacters, lookupWords);
+  const u64 fileWordCount = lookupWords.size() / 2;
+  lookupWords.erase(lookupWords.begin() + fileWordCount / 10, lookupWords.begin() + fileWordCount);
+  std::mt19937 randomGenerator(37);
+  std::shuffle(lookupWords.begin(), lookupWords.end(), randomGenerator);
+
+  Timer timer;
+  StartTimer(timer);
+  bloom_filter filter;
+  buildFilter(fileCharacters, filter, 0.01);
+  f64 timeToBuild = StopTimer(timer);
+  printf("Time to build filter: %5.5f ms, %5.2f bits per key, %u hashes, %5.5f MBs\n", timeToBuild, bitsPerKey(filter),
+         filter.hashCount, filter.totalMemoryAllocated / 1024.0 / 1024.0);
+
+  linked_trie_dictionary linkedTrieDictionary;
+  buildDictionary(fileCharacters, linkedTrieDictionary);
+  compareFilteredContains(linkedTrieDictionary, filter, lookupWords, "linked trie");
+  freeDictionary(linkedTrieDictionary);
+
+  trie_dictionary trieDictionary;
+  buildDictionary(fileCharacters, trieDictionary);
+  compareFilteredContains(trieDictionary, filter, lookupWords, "trie");
+  freeDictionary(trieDictionary);
+
+  packed_trie_dictionary packedTrieDictionary;
+  buildDictionary(fileCharacters, packedTrieDictionary);
+  compareFilteredContains(packedTrieDictionary, filter, lookupWords, "packed trie");
+  freeDictionary(packedTrieDictionary);
+
+  freeBloomFilter(filter);
+}
+
+template<typename Dictionary>
+void testFilteredInsert(const std::vector<char>& fileCharacters) {
+  Dictionary dict;
+  bloom_filter filter;
+  buildDictionary(fileCharacters, dict, filter, 0.01);
+  ASSERT_TRUE(contains(dict, filter, "the"));
+  ASSERT_FALSE(contains(dict, filter, "qzxv"));
+
+  const u64 filterKeyCount = filter.keyCount;
+  ASSERT_TRUE(insertWord(dict, filter, "qzxv"));
+  ASSERT_FALSE(insertWord(dict, filter, "qzxv"));
+  ASSERT_FALSE(insertWord(dict, filter, "Qzxv"));
+  ASSERT_TRUE(contains(dict, filter, "qzxv"));
+  ASSERT_EQ(filter.keyCount, filterKeyCount + 1);
+
+  freeDictionary(dict);
+  freeBloomFilter(filter);
+}
+
+TEST(TrieDictionary, filteredInsert) {
+  std::vector<char> fileCharacters;
+  readFile(wordFile4000, fileCharacters);
+  testFilteredInsert<linked_trie_dictionary>(fileCharacters);
+  testFilteredInsert<trie_dictionary>(fileCharacters);
+}
@@ -2,6 +2,8 @@
 // Created by Connor on 3/12/2022.
 //
 
+#include "arena_allocator.h"
+
 // TODO: clear() function?
 // TODO: malloc more elements when capacity is met
 template<typename S /*key*/, typename T/*value*/>
@@ -31,6 +33,8 @@ struct HashMapTemplate {
   Element* freeElements;
   Element* recyclingElements;
   void* mallocPtr;
+  arena_allocator* arena; // nullptr to malloc() and free() the table
+  bool hugePages; // map the table with 2MB pages when there is no arena
 
   typedef u64 hash_func_hash(const S& key);
   typedef bool hash_func_equals(const S& key1, const S& key2);
@@ -38,7 +42,9 @@ struct HashMapTemplate {
   hash_func_hash* hashFunc;
   hash_func_equals* equalsFunc;
 
-  HashMapTemplate(hash_func_hash* hash, hash_func_equals* equals, u64 firstLevelCapacity_) {
+  HashMapTemplate(hash_func_hash* hash, hash_func_equals* equals, u64 firstLevelCapacity_, arena_allocator* arena_ = nullptr, bool hugePages_ = false) {
+    arena = arena_;
+    hugePages = hugePages_;
     hashFunc = hash;
     equalsFunc = equals;
     firstLevelCapacity = firstLevelCapacity_;
@@ -48,8 +54,10 @@ struct HashMapTemplate {
     u64 additionalElementsMallocSize = additionalElementCapacity * sizeof(Element);
 
     totalMallocSize = firstLevelMallocSize + additionalElementsMallocSize;
-    mallocPtr = malloc(totalMallocSize);
-    memset(mallocPtr, 0, totalMallocSize);
+    mallocPtr = allocateLarge(arena, totalMallocSize, hugePages);
+    if(arena != nullptr || !hugePages) { // mapped pages come zeroed
+      memset(mallocPtr, 0, totalMallocSize);
+    }
     firstLevel = (FirstElement*)mallocPtr;
     freeElements = (Element*)(firstLevel + firstLevelCapacity);
     recyclingElements = nullptr;
@@ -61,7 +69,7 @@ struct HashMapTemplate {
   }
 
   ~HashMapTemplate() {
-    free(mallocPtr);
+    deallocateLarge(arena, mallocPtr, totalMallocSize, hugePages);
   }
 
   Element* nextFreeElement() {
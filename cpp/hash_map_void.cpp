@@ -4,6 +4,8 @@
 // HashMapVoid holds shallow copies (literally just memcpy) of data inserted
 //
 
+#include "arena_allocator.h"
+
 // TODO: Should first level hold a actual elements? or continue to just hold pointers to elements?
 // TODO: Calculate collisions only when asked. No keeping track of them.
 struct HashMapVoid {
@@ -27,6 +29,8 @@ struct HashMapVoid {
   u64 nextElementOffset;
 
   void* mallocPtr;
+  arena_allocator* arena; // nullptr to malloc() and free() the table
+  bool hugePages; // map the table with 2MB pages when there is no arena
   void** firstElementsPtrArray;
   void* unusedElementsArray;
   void* recyclingElementsList;
@@ -35,7 +39,9 @@ struct HashMapVoid {
   hash_func_hash* hashFunc = HashFuncHashStub;
   hash_func_equals* equalsFunc = HashFuncEqualsStub;
 
-  HashMapVoid(u64 keySize_, u64 datumSize_, hash_func_hash* hashFunc_, hash_func_equals* equalsFunc_, u64 capacity = 1024) {
+  HashMapVoid(u64 keySize_, u64 datumSize_, hash_func_hash* hashFunc_, hash_func_equals* equalsFunc_, u64 capacity = 1024, arena_allocator* arena_ = nullptr, bool hugePages_ = false) {
+    arena = arena_;
+    hugePages = hugePages_;
     if(capacity < 2) { // capacity is now allowed to be less than 2
       capacity = 2;
     }
@@ -63,15 +69,17 @@ struct HashMapVoid {
     collisionsCount = 0;
 
     totalMallocSize = firstLevelMemSize + elementsMemSize;
-    mallocPtr = malloc(totalMallocSize);
-    memset(mallocPtr, 0, totalMallocSize);
+    mallocPtr = allocateLarge(arena, totalMallocSize, hugePages);
+    if(arena != nullptr || !hugePages) { // mapped pages come zeroed
+      memset(mallocPtr, 0, totalMallocSize);
+    }
     firstElementsPtrArray = (void**)mallocPtr;
     unusedElementsArray = (void*)((char*)mallocPtr + firstLevelMemSize);
     recyclingElementsList = nullptr;
   }
 
   ~HashMapVoid() {
-    free(mallocPtr);
+    deallocateLarge(arena, mallocPtr, totalMallocSize, hugePages);
   }
 
   void* parseElementPtr_key(void* elementPtr) const {
@@ -106,6 +114,7 @@ struct HashMapVoid {
     // keep old member variables accessible
     u64 old_firstLevelCapacity = firstLevelCapacity;
     void* old_mallocPtr = mallocPtr;
+    u64 old_totalMallocSize = totalMallocSize;
     void** old_firstElementsPtrArray = firstElementsPtrArray;
 
     // update new member variables
@@ -121,8 +130,10 @@ struct HashMapVoid {
     collisionsCount = 0;
 
     totalMallocSize = firstLevelMemSize + elementsMemSize;
-    mallocPtr = malloc(totalMallocSize);
-    memset(mallocPtr, 0, totalMallocSize);
+    mallocPtr = allocateLarge(arena, totalMallocSize, hugePages);
+    if(arena != nullptr || !hugePages) { // mapped pages come zeroed
+      memset(mallocPtr, 0, totalMallocSize);
+    }
     firstElementsPtrArray = (void**)mallocPtr;
     unusedElementsArray = (void*)((char*)mallocPtr + firstLevelMemSize);
     recyclingElementsList = nullptr;
@@ -145,7 +156,7 @@ struct HashMapVoid {
       ++firstElementPtrsIterator;
     }
 
-    free(old_mallocPtr);
+    deallocateLarge(arena, old_mallocPtr, old_totalMallocSize, hugePages);
   }
 
   // Guarantees that the element returned has a next ptr set to nullptr
@@ -332,4 +332,47 @@ TEST(HashMapVoidTest, resize_from_insert) {
     ASSERT_TRUE(hashMapVoid.contains(&testEntry.key));
   }
   ASSERT_FALSE(hashMapVoid.contains(&notInsertedEntry.key));
-}
\ No newline at end of file
+}
+
+HASH_FUNC_HASH(hash_map_test_u64_hash) {
+  return *(u64*)key * 0x9e3779b97f4a7c15ull;
+}
+
+HASH_FUNC_EQUALS(hash_map_test_u64_equals) {
+  return *(u64*)key1 == *(u64*)key2;
+}
+
+// Random lookups into a table far bigger than the TLB covers with 4KB pages. Only timed, TLB misses aren't counted.
+void timeRandomRetrieves(bool hugePages) {
+  const u64 capacity = 1 << 22;
+  const u64 insertCount = capacity / 2;
+  const u64 retrieveCount = 1 << 22;
+  HashMapVoid hashMapVoid(sizeof(u64), sizeof(u64), hash_map_test_u64_hash, hash_map_test_u64_equals, capacity, nullptr, hugePages);
+  for(u64 i = 0; i < insertCount; i++) {
+    hashMapVoid.insert(&i, &i);
+  }
+
+  u64 key = 0;
+  u64 retrievedSum = 0;
+  u64 expectedSum = 0;
+  Timer timer;
+  StartTimer(timer);
+  for(u64 i = 0; i < retrieveCount; i++) {
+    key = (key * 6364136223846793005ull + 1442695040888963407ull);
+    u64 keyInMap = (key >> 32) % insertCount;
+    u64 retrieved;
+    hashMapVoid.retrieve(&keyInMap, &retrieved);
+    retrievedSum += retrieved;
+    expectedSum += keyInMap;
+  }
+  f64 timeForRetrieves = StopTimer(timer);
+  ASSERT_EQ(retrievedSum, expectedSum);
+
+  printf("Time for %llu random retrieves (%s pages, %5.1f MB table): %5.5f ms\n", (unsigned long long)retrieveCount,
+         hugePages ? "2MB" : "4KB", hashMapVoid.totalMallocSize / 1024.0 / 1024.0, timeForRetrieves);
+}
+
+TEST(HashMapVoidTest, hugePages) {
+  timeRandomRetrieves(false);
+  timeRandomRetrieves(true);
+}
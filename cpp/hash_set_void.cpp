@@ -3,6 +3,8 @@
 // Generic hash set by just throwing around void pointers
 //
 
+#include "arena_allocator.h"
+
 // TODO: Should first level hold actual keys? or continue to hold pointers to elements?
 // TODO: Calculate collisions only when asked. No keeping track of them.
 struct HashSetVoid {
@@ -24,6 +26,8 @@ struct HashSetVoid {
   u64 nextElementOffset;
 
   void* mallocPtr;
+  arena_allocator* arena; // nullptr to malloc() and free() the table
+  bool hugePages; // map the table with 2MB pages when there is no arena
   void** firstElementsPtrArray;
   void* unusedElementsArray;
   void* recyclingElementsList;
@@ -32,7 +36,9 @@ struct HashSetVoid {
   hash_func_hash* hashFunc = HashFuncHashStub;
   hash_func_equals* equalsFunc = HashFuncEqualsStub;
 
-  HashSetVoid(u64 keySize_, hash_func_hash* hashFunc_, hash_func_equals* equalsFunc_, u64 capacity = 1024) {
+  HashSetVoid(u64 keySize_, hash_func_hash* hashFunc_, hash_func_equals* equalsFunc_, u64 capacity = 1024, arena_allocator* arena_ = nullptr, bool hugePages_ = false) {
+    arena = arena_;
+    hugePages = hugePages_;
     if(capacity < 2) { // capacity is now allowed to be less than 2
       capacity = 2;
     }
@@ -58,15 +64,17 @@ struct HashSetVoid {
     collisionsCount = 0;
 
     totalMallocSize = firstLevelMemSize + elementsMemSize;
-    mallocPtr = malloc(totalMallocSize);
-    memset(mallocPtr, 0, totalMallocSize);
+    mallocPtr = allocateLarge(arena, totalMallocSize, hugePages);
+    if(arena != nullptr || !hugePages) { // mapped pages come zeroed
+      memset(mallocPtr, 0, totalMallocSize);
+    }
     firstElementsPtrArray = (void**)mallocPtr;
     unusedElementsArray = firstElementsPtrArray + firstLevelCapacity;
     recyclingElementsList = nullptr;
   }
 
   ~HashSetVoid() {
-    free(mallocPtr);
+    deallocateLarge(arena, mallocPtr, totalMallocSize, hugePages);
   }
 
   void* parseElementPtr_key(void* elementPtr) const {
@@ -132,6 +140,7 @@ struct HashSetVoid {
     // keep old member variables accessible
     u64 old_firstLevelCapacity = firstLevelCapacity;
     void* old_mallocPtr = mallocPtr;
+    u64 old_totalMallocSize = totalMallocSize;
     void** old_firstElementsPtrArray = firstElementsPtrArray;
 
     // update new member variables
@@ -147,8 +156,10 @@ struct HashSetVoid {
     collisionsCount = 0;
 
     totalMallocSize = firstLevelMemSize + elementsMemSize;
-    mallocPtr = malloc(totalMallocSize);
-    memset(mallocPtr, 0, totalMallocSize);
+    mallocPtr = allocateLarge(arena, totalMallocSize, hugePages);
+    if(arena != nullptr || !hugePages) { // mapped pages come zeroed
+      memset(mallocPtr, 0, totalMallocSize);
+    }
     firstElementsPtrArray = (void**)mallocPtr;
     unusedElementsArray = (void*)((char*)mallocPtr + firstLevelMemSize);
     recyclingElementsList = nullptr;
@@ -171,7 +182,7 @@ struct HashSetVoid {
       ++firstElementPtrsIterator;
     }
 
-    free(old_mallocPtr);
+    deallocateLarge(arena, old_mallocPtr, old_totalMallocSize, hugePages);
   }
 
   void insert(void* key) {
@@ -3,6 +3,8 @@
 //
 
 #include "test.h"
+#include <random>
+
 #include "linked_list.cpp"
 
 TEST(SinglyLinkedList, addRemove) {
@@ -79,4 +81,668 @@ TEST(SinglyLinkedList, doubleCapacity) {
   }
   ASSERT_EQ(listIter->data, originalCapacity);
   destroy(list);
-}
\ No newline at end of file
+}
+
+// Values in list order, checked against the node invariants
+std::vector<u32> unrolledValues(const unrolled_linked_list& list) {
+  std::vector<u32> values;
+  const unrolled_node* lastNode = nullptr;
+  for(const unrolled_node* node = list.head; node != nullptr; node = node->next) {
+    EXPECT_GT(node->count, 0);
+    EXPECT_LE(node->count, unrolledNodeValueCount);
+    EXPECT_EQ((uintptr_t)node % 64, 0);
+    values.insert(values.end(), node->values, node->values + node->count);
+    lastNode = node;
+  }
+  EXPECT_EQ(lastNode, list.tail);
+  return values;
+}
+
+TEST(UnrolledLinkedList, addRemove) {
+  ASSERT_EQ(sizeof(unrolled_node), 64);
+  unrolled_linked_list list = UnrolledLinkedList();
+
+  addFront(list, 0);
+  addFront(list, 1);
+  addFront(list, 2);
+  addBack(list, 3);
+  addBack(list, 4);
+  addBack(list, 5);
+  ASSERT_EQ(list.count, 6);
+  ASSERT_EQ(unrolledValues(list), std::vector<u32>({2, 1, 0, 3, 4, 5}));
+
+  ASSERT_TRUE(remove(list, 1));
+  ASSERT_TRUE(remove(list, 3));
+  ASSERT_TRUE(remove(list, 5));
+  ASSERT_FALSE(remove(list, 5));
+  ASSERT_TRUE(contains(list, 0));
+  ASSERT_TRUE(contains(list, 2));
+  ASSERT_TRUE(contains(list, 4));
+  ASSERT_FALSE(contains(list, 1));
+  ASSERT_FALSE(contains(list, 3));
+  ASSERT_FALSE(contains(list, 5));
+  ASSERT_EQ(unrolledValues(list), std::vector<u32>({2, 0, 4}));
+
+  ASSERT_TRUE(remove(list, 2));
+  ASSERT_TRUE(remove(list, 0));
+  ASSERT_TRUE(remove(list, 4));
+  ASSERT_EQ(list.head, nullptr);
+  ASSERT_EQ(list.tail, nullptr);
+  ASSERT_EQ(list.nodeCount, 0);
+  addBack(list, 7);
+  ASSERT_EQ(unrolledValues(list), std::vector<u32>({7}));
+
+  destroy(list);
+}
+
+TEST(UnrolledLinkedList, matchesVector) {
+  unrolled_linked_list list = UnrolledLinkedList(4);
+  std::vector<u32> expected;
+  std::mt19937 randomGenerator(41);
+  for(u32 i = 0; i < 20000; i++) {
+    const u32 value = randomGenerator() % 200;
+    switch(randomGenerator() % 4) {
+      case 0:
+        addFront(list, value);
+        expected.insert(expected.begin(), value);
+        break;
+      case 1:
+        addBack(list, value);
+        expected.push_back(value);
+        break;
+      default: {
+        auto found = std::find(expected.begin(), expected.end(), value);
+        ASSERT_EQ(remove(list, value), found != expected.end());
+        if(found != expected.end()) {
+          expected.erase(found);
+        }
+      }
+    }
+    ASSERT_EQ(contains(list, value), std::find(expected.begin(), expected.end(), value) != expected.end());
+  }
+  ASSERT_EQ(list.count, expected.size());
+  ASSERT_EQ(unrolledValues(list), expected);
+  printf("%u values in %u nodes\n", list.count, list.nodeCount);
+
+  destroy(list);
+}
+
+TEST(UnrolledLinkedList, containsAgainstSinglyLinkedList) {
+  const u32 valueCount = 1 << 16;
+  const u32 lookupCount = 2000;
+  singly_linked_list singlyList = SinglyLinkedList(valueCount);
+  unrolled_linked_list unrolledList = UnrolledLinkedList(valueCount);
+  for(u32 i = 0; i < valueCount; i++) {
+    addBack(singlyList, i * 2);
+    addBack(unrolledList, i * 2);
+  }
+
+  Timer timer;
+  StartTimer(timer);
+  u32 singlyFoundCount = 0;
+  for(u32 i = 0; i < lookupCount; i++) {
+    singlyFoundCount += contains(singlyList, i * 64);
+  }
+  f64 timeForSingly = StopTimer(timer);
+  printf("Time for %u contains (singly linked list): %5.5f ms\n", lookupCount, timeForSingly);
+
+  StartTimer(timer);
+  u32 unrolledFoundCount = 0;
+  for(u32 i = 0; i < lookupCount; i++) {
+    unrolledFoundCount += contains(unrolledList, i * 64);
+  }
+  f64 timeForUnrolled = StopTimer(timer);
+  printf("Time for %u contains (unrolled linked list): %5.5f ms\n", lookupCount, timeForUnrolled);
+  ASSERT_EQ(singlyFoundCount, unrolledFoundCount);
+
+  destroy(singlyList);
+  destroy(unrolledList);
+}
+
+TEST(IndexedLinkedList, addRemove) {
+  ASSERT_EQ(sizeof(indexed_node), 8);
+  u32 capacity = 6;
+  indexed_linked_list list = IndexedLinkedList(capacity);
+
+  addFront(list, 0);
+  addFront(list, 1);
+  addFront(list, 2);
+  addBack(list, 3);
+  addBack(list, 4);
+  addBack(list, 5);
+  ASSERT_EQ(list.count, capacity);
+  ASSERT_EQ(list.capacity, capacity);
+
+  remove(list, 1);
+  remove(list, 3);
+  remove(list, 5);
+  ASSERT_TRUE(contains(list, 0));
+  ASSERT_TRUE(contains(list, 2));
+  ASSERT_TRUE(contains(list, 4));
+  ASSERT_FALSE(contains(list, 1));
+  ASSERT_FALSE(contains(list, 3));
+  ASSERT_FALSE(contains(list, 5));
+  ASSERT_EQ(list.count, capacity - 3);
+
+  addFront(list, 1);
+  addBack(list, 3);
+  addBack(list, 5);
+  for(u32 i = 0; i < capacity; i++) {
+    ASSERT_TRUE(contains(list, i));
+  }
+  ASSERT_EQ(list.count, capacity);
+  ASSERT_EQ(list.capacity, capacity); // assert recycled nodes were reused
+
+  // growing keeps both the list and the recycled nodes intact
+  remove(list, 2);
+  for(u32 i = 6; i < 40; i++) {
+    addBack(list, i);
+  }
+  ASSERT_GT(list.capacity, capacity);
+  std::vector<u32> expected = {1, 0, 4, 3, 5};
+  for(u32 i = 6; i < 40; i++) {
+    expected.push_back(i);
+  }
+  std::vector<u32> listData;
+  for(u32 iter = list.head; iter != indexedNodeNull; iter = list.nodes[iter].next) {
+    listData.push_back(list.nodes[iter].data);
+  }
+  ASSERT_EQ(listData, expected);
+  ASSERT_EQ(list.nodes[list.tail].data, 39);
+
+  destroy(list);
+}
+
+template<typename List>
+f64 timeGrowth(List& list, u32 elementCount) {
+  Timer timer;
+  StartTimer(timer);
+  for(u32 i = 0; i < elementCount; i++) {
+    addBack(list, i);
+  }
+  return StopTimer(timer);
+}
+
+void compareGrowth(u32 elementCount) {
+  singly_linked_list singlyList = SinglyLinkedList(32);
+  f64 timeForSingly = timeGrowth(singlyList, elementCount);
+  printf("Time to grow from 32 to %u elements (pointers, %u byte nodes): %5.5f ms\n", elementCount, (u32)sizeof(noop_node_s), timeForSingly);
+  ASSERT_EQ(singlyList.tail->data, elementCount - 1);
+  destroy(singlyList);
+
+  indexed_linked_list indexedList = IndexedLinkedList(32);
+  f64 timeForIndexed = timeGrowth(indexedList, elementCount);
+  printf("Time to grow from 32 to %u elements (indices, %u byte nodes): %5.5f ms\n", elementCount, (u32)sizeof(indexed_node), timeForIndexed);
+  ASSERT_EQ(indexedList.nodes[indexedList.tail].data, elementCount - 1);
+  destroy(indexedList);
+}
+
+TEST(IndexedLinkedList, growthAgainstSinglyLinkedList) {
+  compareGrowth(1 << 22);
+}
+
+// Needs around 3.5GB for the pointer based list at the moment it doubles
+TEST(IndexedLinkedList, DISABLED_growthTo100MAgainstSinglyLinkedList) {
+  compareGrowth(100000000);
+}
+
+TEST(DenseU32List, addRemove) {
+  dense_u32_list list = DenseU32List(4);
+  for(u32 i = 0; i < 100; i++) {
+    add(list, i);
+  }
+  ASSERT_GE(list.capacity, 100);
+  for(u32 i = 0; i < 100; i++) {
+    ASSERT_EQ(list.values[findIndex(list, i)], i);
+  }
+  ASSERT_FALSE(contains(list, 100));
+
+  // every lane of the vector compares, and the scalar tail
+  for(u32 i = 0; i < 100; i += 3) {
+    ASSERT_TRUE(remove(list, i));
+    ASSERT_FALSE(contains(list, i));
+    ASSERT_FALSE(remove(list, i));
+  }
+  ASSERT_EQ(list.count, 100 - 34);
+  for(u32 i = 0; i < 100; i++) {
+    ASSERT_EQ(contains(list, i), i % 3 != 0);
+  }
+
+  destroy(list);
+}
+
+TEST(DenseU32List, matchesMultiset) {
+  dense_u32_list list = DenseU32List();
+  std::vector<u32> expectedCounts(300, 0);
+  u32 expectedCount = 0;
+  std::mt19937 randomGenerator(43);
+  for(u32 i = 0; i < 50000; i++) {
+    const u32 value = randomGenerator() % 300;
+    if(randomGenerator() % 2 == 0) {
+      add(list, value);
+      expectedCounts[value]++;
+      expectedCount++;
+    } else {
+      ASSERT_EQ(remove(list, value), expectedCounts[value] > 0);
+      if(expectedCounts[value] > 0) {
+        expectedCounts[value]--;
+        expectedCount--;
+      }
+    }
+    ASSERT_EQ(contains(list, value), expectedCounts[value] > 0);
+  }
+  ASSERT_EQ(list.count, expectedCount);
+  for(u32 value = 0; value < 300; value++) {
+    ASSERT_EQ((u32)std::count(list.values, list.values + list.count, value), expectedCounts[value]);
+  }
+
+  destroy(list);
+}
+
+TEST(DenseU32List, containsAgainstOtherLists) {
+  const u32 valueCount = 1 << 16;
+  const u32 lookupCount = 2000;
+  singly_linked_list singlyList = SinglyLinkedList(valueCount);
+  unrolled_linked_list unrolledList = UnrolledLinkedList(valueCount);
+  dense_u32_list denseList = DenseU32List(valueCount);
+  for(u32 i = 0; i < valueCount; i++) {
+    addBack(singlyList, i * 2);
+    addBack(unrolledList, i * 2);
+    add(denseList, i * 2);
+  }
+
+  Timer timer;
+  u32 foundCounts[3] = {};
+  StartTimer(timer);
+  for(u32 i = 0; i < lookupCount; i++) {
+    foundCounts[0] += contains(singlyList, i * 64);
+  }
+  printf("Time for %u contains (singly linked list): %5.5f ms\n", lookupCount, StopTimer(timer));
+  StartTimer(timer);
+  for(u32 i = 0; i < lookupCount; i++) {
+    foundCounts[1] += contains(unrolledList, i * 64);
+  }
+  printf("Time for %u contains (unrolled linked list): %5.5f ms\n", lookupCount, StopTimer(timer));
+  StartTimer(timer);
+  for(u32 i = 0; i < lookupCount; i++) {
+    foundCounts[2] += contains(denseList, i * 64);
+  }
+  printf("Time for %u contains (dense list): %5.5f ms\n", lookupCount, StopTimer(timer));
+  ASSERT_EQ(foundCounts[0], foundCounts[1]);
+  ASSERT_EQ(foundCounts[0], foundCounts[2]);
+
+  StartTimer(timer);
+  for(u32 i = 0; i < valueCount; i += 16) {
+    remove(singlyList, i * 2);
+  }
+  printf("Time for %u removes (singly linked list): %5.5f ms\n", valueCount / 16, StopTimer(timer));
+  StartTimer(timer);
+  for(u32 i = 0; i < valueCount; i += 16) {
+    remove(denseList, i * 2);
+  }
+  printf("Time for %u removes (dense list): %5.5f ms\n", valueCount / 16, StopTimer(timer));
+  ASSERT_EQ(singlyList.count, denseList.count);
+
+  destroy(singlyList);
+  destroy(unrolledList);
+  destroy(denseList);
+}
+
+std::vector<u32> doublyValues(const doubly_linked_list& list) {
+  std::vector<u32> values;
+  const noop_node_d* prev = nullptr;
+  for(const noop_node_d* iter = list.head; iter != nullptr; iter = iter->next) {
+    EXPECT_EQ(iter->prev, prev);
+    values.push_back(iter->data);
+    prev = iter;
+  }
+  EXPECT_EQ(prev, list.tail);
+  EXPECT_EQ(values.size(), list.count);
+  return values;
+}
+
+TEST(DoublyLinkedList, handles) {
+  doubly_linked_list list = DoublyLinkedList(2);
+  std::vector<noop_node_d*> handles;
+  for(u32 i = 0; i < 10; i++) { // several blocks
+    handles.push_back(addBack(list, i));
+  }
+  ASSERT_EQ(doublyValues(list), std::vector<u32>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+  for(u32 i = 0; i < 10; i++) {
+    ASSERT_EQ(handles[i]->data, i); // growing never moved a node
+  }
+
+  removeByHandle(list, handles[0]);
+  removeByHandle(list, handles[9]);
+  removeByHandle(list, handles[5]);
+  ASSERT_EQ(doublyValues(list), std::vector<u32>({1, 2, 3, 4, 6, 7, 8}));
+
+  moveToFront(list, handles[8]);
+  moveToFront(list, handles[4]);
+  moveToFront(list, handles[4]);
+  ASSERT_EQ(doublyValues(list), std::vector<u32>({4, 8, 1, 2, 3, 6, 7}));
+
+  u32 data;
+  ASSERT_TRUE(popBack(list, data));
+  ASSERT_EQ(data, 7);
+  handles[7] = addFront(list, 10);
+  ASSERT_EQ(doublyValues(list), std::vector<u32>({10, 4, 8, 1, 2, 3, 6}));
+  ASSERT_TRUE(remove(list, 1));
+  ASSERT_FALSE(contains(list, 1));
+  ASSERT_EQ(list.mallocPtrs.size(), 3); // removed nodes were recycled
+
+  while(popBack(list, data)) {}
+  ASSERT_EQ(list.head, nullptr);
+  ASSERT_EQ(list.tail, nullptr);
+  ASSERT_EQ(list.count, 0);
+  addBack(list, 11);
+  ASSERT_EQ(doublyValues(list), std::vector<u32>({11}));
+
+  destroy(list);
+}
+
+// An LRU of keys: a hit moves the key's node to the front, a miss evicts the back
+TEST(DoublyLinkedList, lruAgainstSearch) {
+  const u32 lruCapacity = 4096;
+  const u32 keyRange = lruCapacity * 2;
+  const u32 accessCount = 50000;
+  std::mt19937 randomGenerator(45);
+  std::vector<u32> accesses(accessCount);
+  for(u32& access : accesses) {
+    access = randomGenerator() % keyRange;
+  }
+
+  Timer timer;
+  StartTimer(timer);
+  doubly_linked_list list = DoublyLinkedList(lruCapacity);
+  std::vector<noop_node_d*> handles(keyRange, nullptr);
+  u32 hitCount = 0;
+  for(u32 key : accesses) {
+    if(handles[key] != nullptr) {
+      moveToFront(list, handles[key]);
+      hitCount++;
+      continue;
+    }
+    if(list.count == lruCapacity) {
+      u32 evictedKey = 0;
+      ASSERT_TRUE(popBack(list, evictedKey));
+      handles[evictedKey] = nullptr;
+    }
+    handles[key] = addFront(list, key);
+  }
+  f64 timeForHandles = StopTimer(timer);
+  printf("Time for %u LRU accesses (handles): %5.5f ms\n", accessCount, timeForHandles);
+
+  // the same with only values to go by, every hit searches the list
+  StartTimer(timer);
+  doubly_linked_list searchList = DoublyLinkedList(lruCapacity);
+  u32 searchHitCount = 0;
+  for(u32 key : accesses) {
+    noop_node_d* node = find(searchList, key);
+    if(node != nullptr) {
+      moveToFront(searchList, node);
+      searchHitCount++;
+      continue;
+    }
+    if(searchList.count == lruCapacity) {
+      u32 evictedKey = 0;
+      ASSERT_TRUE(popBack(searchList, evictedKey));
+    }
+    addFront(searchList, key);
+  }
+  f64 timeForSearch = StopTimer(timer);
+  printf("Time for %u LRU accesses (search): %5.5f ms\n", accessCount, timeForSearch);
+  ASSERT_EQ(hitCount, searchHitCount);
+  ASSERT_EQ(doublyValues(list), doublyValues(searchList));
+
+  destroy(list);
+  destroy(searchList);
+}
+
+std::vector<u32> singlyValues(const singly_linked_list& list) {
+  std::vector<u32> values;
+  const noop_node_s* last = nullptr;
+  for(const noop_node_s* iter = list.head; iter != nullptr; iter = iter->next) {
+    values.push_back(iter->data);
+    last = iter;
+  }
+  EXPECT_EQ(last, list.tail);
+  EXPECT_EQ(values.size(), list.count);
+  return values;
+}
+
+TEST(SinglyLinkedList, appendArrayAndSplice) {
+  singly_linked_list list = SinglyLinkedList(4);
+  addBack(list, 100);
+  addBack(list, 101);
+  addBack(list, 102);
+  remove(list, 101); // one recycled node to use up first
+  const u32 values[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+  appendArray(list, values, ArrayCount(values));
+  ASSERT_EQ(list.capacity, 16); // grown once
+  ASSERT_EQ(list.recycledNodes, nullptr);
+  ASSERT_EQ(singlyValues(list), std::vector<u32>({100, 102, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+  appendArray(list, values, 0);
+  addBack(list, 10);
+  ASSERT_EQ(list.count, 13);
+
+  singly_linked_list other = SinglyLinkedList(2);
+  appendArray(other, values, 3);
+  splice(list, other);
+  ASSERT_EQ(other.count, 0);
+  ASSERT_EQ(other.head, nullptr);
+  ASSERT_EQ(singlyValues(list), std::vector<u32>({100, 102, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 0, 1, 2}));
+  appendArray(other, values + 5, 2); // other is still usable
+  ASSERT_EQ(singlyValues(other), std::vector<u32>({5, 6}));
+
+  singly_linked_list empty = SinglyLinkedList(1);
+  splice(empty, other);
+  ASSERT_EQ(singlyValues(empty), std::vector<u32>({5, 6}));
+
+  destroy(list);
+  destroy(other);
+  destroy(empty);
+}
+
+TEST(SinglyLinkedList, growFromNoCapacity) {
+  const u32 values[] = {0, 1, 2, 3, 4};
+  singly_linked_list list = SinglyLinkedList(0);
+  appendArray(list, values, ArrayCount(values));
+  ASSERT_EQ(list.capacity, 8);
+  ASSERT_EQ(singlyValues(list), std::vector<u32>({0, 1, 2, 3, 4}));
+
+  // destroy() leaves no capacity, the list can still be used again
+  destroy(list);
+  addBack(list, 7);
+  ASSERT_EQ(list.capacity, 1);
+  appendArray(list, values, ArrayCount(values));
+  ASSERT_EQ(list.capacity, 8);
+  ASSERT_EQ(singlyValues(list), std::vector<u32>({7, 0, 1, 2, 3, 4}));
+  destroy(list);
+}
+
+TEST(SinglyLinkedList, split) {
+  singly_linked_list list = SinglyLinkedList(8);
+  const u32 values[] = {0, 1, 2, 3, 4, 5, 6};
+  appendArray(list, values, ArrayCount(values));
+
+  singly_linked_list back;
+  split(list, 4, back);
+  ASSERT_EQ(singlyValues(list), std::vector<u32>({0, 1, 2, 3}));
+  ASSERT_EQ(singlyValues(back), std::vector<u32>({4, 5, 6}));
+  appendArray(list, values, 3); // reuses the split off nodes
+  ASSERT_EQ(list.capacity, 8);
+  ASSERT_EQ(singlyValues(list), std::vector<u32>({0, 1, 2, 3, 0, 1, 2}));
+  destroy(back);
+
+  split(list, 10, back);
+  ASSERT_EQ(list.count, 7);
+  ASSERT_EQ(back.count, 0);
+  destroy(back);
+  split(list, 0, back);
+  ASSERT_EQ(singlyValues(list), std::vector<u32>());
+  ASSERT_EQ(singlyValues(back), std::vector<u32>({0, 1, 2, 3, 0, 1, 2}));
+  destroy(back);
+
+  destroy(list);
+}
+
+TEST(SinglyLinkedList, sharedPool) {
+  singly_node_pool pool = SinglyNodePool(4);
+  singly_linked_list list = SinglyLinkedList(pool);
+  singly_linked_list other = SinglyLinkedList(pool);
+  const u32 values[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+  appendArray(list, values, 6); // more than the first block
+  addBack(other, 100);
+  addBack(other, 101);
+  ASSERT_EQ(pool.mallocPtrs.size(), 2);
+
+  // splice relinks the nodes of other rather than copying their values
+  noop_node_s* otherHead = other.head;
+  splice(list, other);
+  ASSERT_EQ(singlyValues(list), std::vector<u32>({0, 1, 2, 3, 4, 5, 100, 101}));
+  ASSERT_EQ(singlyValues(other), std::vector<u32>());
+  ASSERT_EQ(list.head->next->next->next->next->next->next, otherHead);
+
+  // and so does split
+  noop_node_s* backHead = list.head->next->next;
+  singly_linked_list back;
+  split(list, 2, back);
+  ASSERT_EQ(back.pool, &pool);
+  ASSERT_EQ(back.head, backHead);
+  ASSERT_EQ(singlyValues(list), std::vector<u32>({0, 1}));
+  ASSERT_EQ(singlyValues(back), std::vector<u32>({2, 3, 4, 5, 100, 101}));
+
+  // nodes a list gives up go back to the pool for any list on it
+  u32 front;
+  ASSERT_TRUE(popFront(back, front));
+  ASSERT_EQ(front, 2);
+  ASSERT_EQ(pool.recycledNodes, backHead);
+  addBack(other, 7);
+  ASSERT_EQ(other.head, backHead);
+
+  sort(back);
+  merge(list, back);
+  ASSERT_EQ(singlyValues(list), std::vector<u32>({0, 1, 3, 4, 5, 100, 101}));
+  clear(list);
+  appendArray(list, values, ArrayCount(values)); // reuses the cleared nodes before taking more from the pool
+  ASSERT_EQ(pool.mallocPtrs.size(), 2);
+  ASSERT_EQ(singlyValues(list), std::vector<u32>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+
+  destroy(list);
+  destroy(other);
+  destroy(back);
+  destroy(pool);
+}
+
+TEST(SinglyLinkedList, sortAndMerge) {
+  std::mt19937 randomGenerator(47);
+  const u32 valueCounts[] = {0, 1, 2, 3, 7, 64, 1000, 4097};
+  singly_node_pool pool = SinglyNodePool();
+  for(u32 valueCount : valueCounts) {
+    for(u32 sharedPool = 0; sharedPool < 2; sharedPool++) { // sortValues(), then sortNodes()
+      std::vector<u32> values(valueCount);
+      for(u32& value : values) {
+        value = randomGenerator() % 500;
+      }
+      singly_linked_list list = sharedPool ? SinglyLinkedList(pool) : SinglyLinkedList();
+      appendArray(list, values.data(), valueCount);
+      sort(list);
+      std::sort(values.begin(), values.end());
+      ASSERT_EQ(singlyValues(list), values);
+
+      std::vector<u32> otherValues(valueCount / 2 + 1);
+      for(u32& value : otherValues) {
+        value = randomGenerator() % 500;
+      }
+      std::sort(otherValues.begin(), otherValues.end());
+      singly_linked_list other = sharedPool ? SinglyLinkedList(pool) : SinglyLinkedList();
+      appendArray(other, otherValues.data(), (u32)otherValues.size());
+      merge(list, other);
+      values.insert(values.end(), otherValues.begin(), otherValues.end());
+      std::sort(values.begin(), values.end());
+      ASSERT_EQ(singlyValues(list), values);
+      ASSERT_EQ(other.count, 0);
+
+      destroy(list);
+      destroy(other);
+    }
+  }
+  destroy(pool);
+}
+
+TEST(SinglyLinkedList, bulkPerformance) {
+  const u32 valueCount = 1 << 20;
+  std::mt19937 randomGenerator(47);
+  std::vector<u32> values(valueCount);
+  for(u32& value : values) {
+    value = randomGenerator();
+  }
+
+  Timer timer;
+  StartTimer(timer);
+  singly_linked_list addBackList = SinglyLinkedList();
+  for(u32 value : values) {
+    addBack(addBackList, value);
+  }
+  f64 timeForAddBack = StopTimer(timer);
+  printf("Time to build a list of %u values (addBack): %5.5f ms\n", valueCount, timeForAddBack);
+
+  StartTimer(timer);
+  singly_linked_list appendList = SinglyLinkedList();
+  appendArray(appendList, values.data(), valueCount);
+  f64 timeForAppend = StopTimer(timer);
+  printf("Time to build a list of %u values (appendArray): %5.5f ms\n", valueCount, timeForAppend);
+  ASSERT_EQ(singlyValues(addBackList), singlyValues(appendList));
+
+  singly_linked_list relinkedList = SinglyLinkedList();
+  appendArray(relinkedList, values.data(), valueCount);
+  StartTimer(timer);
+  sortNodes(relinkedList);
+  f64 timeForSortNodes = StopTimer(timer);
+  printf("Time to sort a list of %u values (sortNodes, bottom-up merge sort): %5.5f ms\n", valueCount, timeForSortNodes);
+
+  StartTimer(timer);
+  sort(appendList);
+  f64 timeForSort = StopTimer(timer);
+  printf("Time to sort a list of %u values (sort, values through a scratch buffer): %5.5f ms\n", valueCount, timeForSort);
+  ASSERT_EQ(singlyValues(appendList), singlyValues(relinkedList));
+  destroy(relinkedList);
+
+  // the round trip through a vector, rebuilding the list
+  StartTimer(timer);
+  std::vector<u32> sortedValues;
+  sortedValues.reserve(addBackList.count);
+  for(noop_node_s* iter = addBackList.head; iter != nullptr; iter = iter->next) {
+    sortedValues.push_back(iter->data);
+  }
+  std::sort(sortedValues.begin(), sortedValues.end());
+  clear(addBackList);
+  appendArray(addBackList, sortedValues.data(), (u32)sortedValues.size());
+  f64 timeForVectorSort = StopTimer(timer);
+  printf("Time to sort a list of %u values (copy to vector, std::sort, copy back): %5.5f ms\n", valueCount, timeForVectorSort);
+  ASSERT_EQ(singlyValues(appendList), sortedValues);
+
+  // splicing lists that own their nodes copies the values, lists on a shared pool only relink
+  StartTimer(timer);
+  splice(addBackList, appendList);
+  f64 timeForCopySplice = StopTimer(timer);
+  printf("Time to splice a list of %u values (own pools, copied): %5.5f ms\n", valueCount, timeForCopySplice);
+
+  singly_node_pool pool = SinglyNodePool();
+  singly_linked_list pooledList = SinglyLinkedList(pool);
+  singly_linked_list otherPooledList = SinglyLinkedList(pool);
+  appendArray(pooledList, values.data(), valueCount);
+  appendArray(otherPooledList, values.data(), valueCount);
+  StartTimer(timer);
+  splice(pooledList, otherPooledList);
+  f64 timeForPooledSplice = StopTimer(timer);
+  printf("Time to splice a list of %u values (shared pool, relinked): %5.5f ms\n", valueCount, timeForPooledSplice);
+  ASSERT_EQ(pooledList.count, 2 * valueCount);
+
+  destroy(addBackList);
+  destroy(appendList);
+  destroy(pooledList);
+  destroy(otherPooledList);
+  destroy(pool);
+}
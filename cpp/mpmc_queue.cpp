@@ -0,0 +1,147 @@
+//
+// Lock-free multi-producer/multi-consumer queue of u32s
+// A Michael-Scott queue: a singly linked list with a dummy node at the head, where producers swing the tail's next
+// link and then the tail, and consumers swing the head, all with compare-and-swap. Nodes come from a pool allocated
+// up front, like singly_linked_list's nodePool, and freed nodes go on a lock-free recycled stack.
+// Links are 32-bit node indices paired with a 32-bit tag that every successful CAS increments. A node can be dequeued,
+// recycled and enqueued again between another thread reading a link and trying its CAS, the tag makes that CAS fail
+// where a bare index would match and corrupt the list (the ABA problem).
+//
+
+#include <atomic>
+#include <new>
+
+#include "arena_allocator.h"
+
+const u32 mpmcQueueNullIndex = U32_MAX;
+
+struct mpmc_queue_node {
+  std::atomic<u64> next; // tagged index, also the link in the recycled stack
+  std::atomic<u32> data; // a slow consumer can still be reading it while the node is recycled and refilled
+};
+
+struct mpmc_queue {
+  alignas(64) std::atomic<u64> head; // tagged index of the dummy node
+  alignas(64) std::atomic<u64> tail;
+  alignas(64) std::atomic<u64> recycledNodes; // tagged index of the top of the recycled stack
+  mpmc_queue_node* nodes;
+  u32 capacity;
+  arena_allocator* arena; // nullptr to malloc() and free() the node pool
+};
+
+u64 taggedIndex(u32 index, u32 tag) {
+  return ((u64)tag << 32) | index;
+}
+
+u32 taggedIndexIndex(u64 tagged) {
+  return (u32)tagged;
+}
+
+u32 taggedIndexTag(u64 tagged) {
+  return (u32)(tagged >> 32);
+}
+
+void pushRecycled(mpmc_queue& queue, u32 nodeIndex) {
+  u64 top = queue.recycledNodes.load();
+  do {
+    const u32 nextTag = taggedIndexTag(queue.nodes[nodeIndex].next.load());
+    queue.nodes[nodeIndex].next.store(taggedIndex(taggedIndexIndex(top), nextTag + 1));
+  } while(!queue.recycledNodes.compare_exchange_weak(top, taggedIndex(nodeIndex, taggedIndexTag(top) + 1)));
+}
+
+// Returns mpmcQueueNullIndex when every node is in the queue
+u32 popRecycled(mpmc_queue& queue) {
+  u64 top = queue.recycledNodes.load();
+  while(taggedIndexIndex(top) != mpmcQueueNullIndex) {
+    const u64 next = queue.nodes[taggedIndexIndex(top)].next.load();
+    if(queue.recycledNodes.compare_exchange_weak(top, taggedIndex(taggedIndexIndex(next), taggedIndexTag(top) + 1))) {
+      return taggedIndexIndex(top);
+    }
+  }
+  return mpmcQueueNullIndex;
+}
+
+// Holds up to capacity values. Not thread safe, nor is destroy().
+// With an arena, the node pool is allocated from it and destroy() leaves it to the arena
+void initQueue(mpmc_queue& queue, u32 capacity, arena_allocator* arena = nullptr) {
+  Assert(capacity < mpmcQueueNullIndex - 1);
+  queue.capacity = capacity;
+  queue.arena = arena;
+  const u32 nodeCount = capacity + 1; // and the dummy
+  queue.nodes = (mpmc_queue_node*)allocate(arena, sizeof(mpmc_queue_node) * nodeCount, alignof(mpmc_queue_node));
+  for(u32 i = 0; i < nodeCount; i++) {
+    new(queue.nodes + i) mpmc_queue_node();
+    queue.nodes[i].next.store(taggedIndex(i + 1 < nodeCount ? i + 1 : mpmcQueueNullIndex, 0));
+    queue.nodes[i].data.store(0);
+  }
+  queue.nodes[0].next.store(taggedIndex(mpmcQueueNullIndex, 0));
+  queue.head.store(taggedIndex(0, 0));
+  queue.tail.store(taggedIndex(0, 0));
+  queue.recycledNodes.store(taggedIndex(capacity > 0 ? 1 : mpmcQueueNullIndex, 0));
+}
+
+void destroy(mpmc_queue& queue) {
+  deallocate(queue.arena, queue.nodes);
+  queue.nodes = nullptr;
+  queue.capacity = 0;
+}
+
+// Returns false when the queue is full
+bool enqueue(mpmc_queue& queue, u32 data) {
+  const u32 nodeIndex = popRecycled(queue);
+  if(nodeIndex == mpmcQueueNullIndex) {
+    return false;
+  }
+  mpmc_queue_node& node = queue.nodes[nodeIndex];
+  node.data.store(data, std::memory_order_relaxed);
+  node.next.store(taggedIndex(mpmcQueueNullIndex, taggedIndexTag(node.next.load()) + 1));
+
+  u64 tail;
+  while(true) {
+    tail = queue.tail.load();
+    u64 next = queue.nodes[taggedIndexIndex(tail)].next.load();
+    if(tail != queue.tail.load()) {
+      continue;
+    }
+
+    if(taggedIndexIndex(next) == mpmcQueueNullIndex) {
+      if(queue.nodes[taggedIndexIndex(tail)].next.compare_exchange_weak(next, taggedIndex(nodeIndex, taggedIndexTag(next) + 1))) {
+        break;
+      }
+    } else { // tail fell behind, help the producer that linked next
+      queue.tail.compare_exchange_weak(tail, taggedIndex(taggedIndexIndex(next), taggedIndexTag(tail) + 1));
+    }
+  }
+  queue.tail.compare_exchange_strong(tail, taggedIndex(nodeIndex, taggedIndexTag(tail) + 1));
+  return true;
+}
+
+// Returns false when the queue is empty
+bool dequeue(mpmc_queue& queue, u32& outData) {
+  u64 head;
+  while(true) {
+    head = queue.head.load();
+    u64 tail = queue.tail.load();
+    const u64 next = queue.nodes[taggedIndexIndex(head)].next.load();
+    if(head != queue.head.load()) {
+      continue;
+    }
+
+    if(taggedIndexIndex(head) == taggedIndexIndex(tail)) {
+      if(taggedIndexIndex(next) == mpmcQueueNullIndex) {
+        return false;
+      }
+      queue.tail.compare_exchange_weak(tail, taggedIndex(taggedIndexIndex(next), taggedIndexTag(tail) + 1));
+    } else {
+      // read before the CAS, afterwards the node can be dequeued and recycled by someone else
+      outData = queue.nodes[taggedIndexIndex(next)].data.load(std::memory_order_relaxed);
+      if(queue.head.compare_exchange_weak(head, taggedIndex(taggedIndexIndex(next), taggedIndexTag(head) + 1))) {
+        break;
+      }
+    }
+  }
+
+  // next is the new dummy, the old dummy goes back to the pool
+  pushRecycled(queue, taggedIndexIndex(head));
+  return true;
+}
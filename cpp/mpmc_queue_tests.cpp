@@ -0,0 +1,133 @@
+#include "test.h"
+#include <mutex>
+#include <thread>
+
+#include "linked_list.cpp"
+#include "mpmc_queue.cpp"
+
+TEST(MpmcQueue, singleThreadFifo) {
+  const u32 capacity = 8;
+  mpmc_queue queue;
+  initQueue(queue, capacity);
+
+  u32 data;
+  ASSERT_FALSE(dequeue(queue, data));
+  for(u32 round = 0; round < 3; round++) { // nodes get recycled
+    for(u32 i = 0; i < capacity; i++) {
+      ASSERT_TRUE(enqueue(queue, round * 100 + i));
+    }
+    ASSERT_FALSE(enqueue(queue, 999));
+    for(u32 i = 0; i < capacity; i++) {
+      ASSERT_TRUE(dequeue(queue, data));
+      ASSERT_EQ(data, round * 100 + i);
+    }
+    ASSERT_FALSE(dequeue(queue, data));
+  }
+
+  destroy(queue);
+}
+
+// Every producer enqueues valueCountPerProducer values, the consumers keep dequeuing until all of them came out.
+// Returns the time taken. outSum and outInOrder let callers check nothing was lost and each producer's values stayed
+// in order.
+template<typename Enqueue, typename Dequeue>
+f64 runProducersAndConsumers(u32 producerCount, u32 consumerCount, u32 valueCountPerProducer,
+                             Enqueue enqueueFunc, Dequeue dequeueFunc, u64& outSum, bool& outInOrder) {
+  std::atomic<u32> dequeuedCount(0);
+  std::atomic<u64> sum(0);
+  std::atomic<bool> inOrder(true);
+  const u32 totalCount = producerCount * valueCountPerProducer;
+
+  Timer timer;
+  StartTimer(timer);
+  std::vector<std::thread> threads;
+  for(u32 producerIndex = 0; producerIndex < producerCount; producerIndex++) {
+    threads.emplace_back([&, producerIndex]() {
+      for(u32 i = 0; i < valueCountPerProducer; i++) {
+        const u32 value = (producerIndex << 24) | i;
+        while(!enqueueFunc(value)) {
+          std::this_thread::yield(); // full
+        }
+      }
+    });
+  }
+  for(u32 consumerIndex = 0; consumerIndex < consumerCount; consumerIndex++) {
+    threads.emplace_back([&]() {
+      std::vector<s64> lastValues(producerCount, -1);
+      u64 consumerSum = 0;
+      while(dequeuedCount.load() < totalCount) {
+        u32 value;
+        if(!dequeueFunc(value)) {
+          std::this_thread::yield(); // empty
+          continue;
+        }
+        dequeuedCount++;
+        const u32 producerIndex = value >> 24;
+        const u32 i = value & 0xFFFFFF;
+        if((s64)i <= lastValues[producerIndex]) {
+          inOrder = false;
+        }
+        lastValues[producerIndex] = i;
+        consumerSum += value;
+      }
+      sum += consumerSum;
+    });
+  }
+  for(std::thread& thread : threads) {
+    thread.join();
+  }
+  f64 time = StopTimer(timer);
+  outSum = sum.load();
+  outInOrder = inOrder.load();
+  return time;
+}
+
+TEST(MpmcQueue, throughputAgainstMutexList) {
+  const u32 valueCountPerProducer = 200000;
+  const u32 queueCapacity = 1024;
+  const u32 threadCounts[][2] = {{1, 1}, {1, 4}, {4, 1}, {2, 2}, {4, 4}};
+  for(const u32* producersAndConsumers : threadCounts) {
+    const u32 producerCount = producersAndConsumers[0];
+    const u32 consumerCount = producersAndConsumers[1];
+    u64 expectedSum = 0;
+    for(u32 producerIndex = 0; producerIndex < producerCount; producerIndex++) {
+      for(u32 i = 0; i < valueCountPerProducer; i++) {
+        expectedSum += (producerIndex << 24) | i;
+      }
+    }
+
+    std::mutex listMutex;
+    singly_linked_list list = SinglyLinkedList(queueCapacity);
+    u64 sum;
+    bool inOrder;
+    f64 timeForMutexList = runProducersAndConsumers(producerCount, consumerCount, valueCountPerProducer,
+      [&](u32 value) {
+        std::lock_guard<std::mutex> lock(listMutex);
+        if(list.count == queueCapacity) {
+          return false;
+        }
+        addBack(list, value);
+        return true;
+      },
+      [&](u32& value) {
+        std::lock_guard<std::mutex> lock(listMutex);
+        return popFront(list, value);
+      }, sum, inOrder);
+    ASSERT_EQ(sum, expectedSum);
+    ASSERT_TRUE(inOrder);
+    destroy(list);
+
+    mpmc_queue queue;
+    initQueue(queue, queueCapacity);
+    f64 timeForQueue = runProducersAndConsumers(producerCount, consumerCount, valueCountPerProducer,
+      [&](u32 value) { return enqueue(queue, value); },
+      [&](u32& value) { return dequeue(queue, value); }, sum, inOrder);
+    ASSERT_EQ(sum, expectedSum);
+    ASSERT_TRUE(inOrder);
+    destroy(queue);
+
+    const f64 totalCount = (f64)producerCount * valueCountPerProducer;
+    printf("%u producers, %u consumers: %6.2f M values/s (mutex list), %6.2f M values/s (lock-free queue)\n",
+           producerCount, consumerCount, totalCount / timeForMutexList / 1000.0, totalCount / timeForQueue / 1000.0);
+  }
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+//
+// Fixed-size object pool for many threads
+// Each thread keeps a pool_thread_cache of two magazines, small stacks of free objects. Allocating pops from the
+// loaded magazine and freeing pushes to it, with no locks and no shared cache lines. Only when both of a thread's
+// magazines are empty (or both full) does it go to the shared depot under a mutex, trading a whole magazine at a time,
+// so the lock is taken at most once every poolMagazineCapacity operations. Objects freed by a different thread than
+// the one that allocated them simply travel through the depot.
+//
+
+#include <mutex>
+#include <vector>
+#include <stdlib.h>
+
+#include "../types.h"
+
+const u32 poolMagazineCapacity = 64;
+const u64 poolDefaultObjectsPerBlock = 4096;
+
+struct pool_magazine {
+  u32 count;
+  pool_magazine* next; // in the depot's full or empty magazine list
+  void* objects[poolMagazineCapacity];
+};
+
+struct pool_allocator {
+  u64 objectSize;
+  u64 alignment;
+  u64 objectsPerBlock;
+
+  // depot, only touched with depotMutex held
+  std::mutex depotMutex;
+  pool_magazine* fullMagazines;
+  pool_magazine* emptyMagazines;
+  u8* freeObjects; // never handed out yet, in the most recent block
+  u64 remainingObjects;
+  std::vector<void*> mallocPtrs;
+  u64 totalMemoryAllocated;
+};
+
+struct alignas(64) pool_thread_cache { // one cache line each, so caches kept side by side don't false share
+  pool_magazine* loaded;
+  pool_magazine* previous;
+};
+
+// objectSize is rounded up to keep every object aligned to alignment, a power of two
+void initPool(pool_allocator& pool, u64 objectSize, u64 alignment = 16, u64 objectsPerBlock = poolDefaultObjectsPerBlock) {
+  Assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+  pool.objectSize = (MAX(objectSize, 1) + (alignment - 1)) & ~(alignment - 1);
+  pool.alignment = alignment;
+  pool.objectsPerBlock = MAX(objectsPerBlock, poolMagazineCapacity);
+  pool.fullMagazines = nullptr;
+  pool.emptyMagazines = nullptr;
+  pool.freeObjects = nullptr;
+  pool.remainingObjects = 0;
+  pool.mallocPtrs.clear();
+  pool.totalMemoryAllocated = 0;
+}
+
+// Expects the depot mutex to be held
+pool_magazine* newMagazine(pool_allocator& pool) {
+  pool_magazine* magazine = (pool_magazine*)malloc(sizeof(pool_magazine));
+  pool.mallocPtrs.push_back(magazine);
+  pool.totalMemoryAllocated += sizeof(pool_magazine);
+  magazine->count = 0;
+  magazine->next = nullptr;
+  return magazine;
+}
+
+// Expects the depot mutex to be held. Fills an empty magazine with objects that were never handed out.
+void fillFromBlock(pool_allocator& pool, pool_magazine* magazine) {
+  while(magazine->count < poolMagazineCapacity) {
+    if(pool.remainingObjects == 0) {
+      const u64 blockSize = pool.objectSize * pool.objectsPerBlock;
+      void* mallocPtr = malloc(blockSize + pool.alignment); // room to align the first object
+      pool.mallocPtrs.push_back(mallocPtr);
+      pool.totalMemoryAllocated += blockSize + pool.alignment;
+      pool.freeObjects = (u8*)(((uintptr_t)mallocPtr + (pool.alignment - 1)) & ~(uintptr_t)(pool.alignment - 1));
+      pool.remainingObjects = pool.objectsPerBlock;
+    }
+    magazine->objects[magazine->count++] = pool.freeObjects;
+    pool.freeObjects += pool.objectSize;
+    pool.remainingObjects--;
+  }
+}
+
+void initThreadCache(pool_allocator& pool, pool_thread_cache& cache) {
+  std::lock_guard<std::mutex> depotLock(pool.depotMutex);
+  cache.loaded = newMagazine(pool);
+  cache.previous = newMagazine(pool);
+}
+
+// Hands the thread's objects back to the depot. The cache can't be used again without initThreadCache().
+void flushThreadCache(pool_allocator& pool, pool_thread_cache& cache) {
+  std::lock_guard<std::mutex> depotLock(pool.depotMutex);
+  pool_magazine* magazines[] = {cache.loaded, cache.previous};
+  for(pool_magazine* magazine : magazines) {
+    pool_magazine*& depotList = (magazine->count > 0) ? pool.fullMagazines : pool.emptyMagazines;
+    magazine->next = depotList;
+    depotList = magazine;
+  }
+  cache = {};
+}
+
+void* allocate(pool_allocator& pool, pool_thread_cache& cache) {
+  if(cache.loaded->count == 0) {
+    if(cache.previous->count > 0) {
+      std::swap(cache.loaded, cache.previous);
+    } else {
+      // both magazines empty, trade one for a full magazine from the depot
+      std::lock_guard<std::mutex> depotLock(pool.depotMutex);
+      if(pool.fullMagazines != nullptr) {
+        cache.previous->next = pool.emptyMagazines;
+        pool.emptyMagazines = cache.previous;
+        cache.previous = cache.loaded;
+        cache.loaded = pool.fullMagazines;
+        pool.fullMagazines = cache.loaded->next;
+      } else {
+        fillFromBlock(pool, cache.loaded);
+      }
+    }
+  }
+  return cache.loaded->objects[--cache.loaded->count];
+}
+
+void deallocate(pool_allocator& pool, pool_thread_cache& cache, void* object) {
+  if(cache.loaded->count == poolMagazineCapacity) {
+    if(cache.previous->count < poolMagazineCapacity) {
+      std::swap(cache.loaded, cache.previous);
+    } else {
+      // both magazines full, trade one for an empty magazine from the depot
+      std::lock_guard<std::mutex> depotLock(pool.depotMutex);
+      cache.previous->next = pool.fullMagazines;
+      pool.fullMagazines = cache.previous;
+      cache.previous = cache.loaded;
+      if(pool.emptyMagazines != nullptr) {
+        cache.loaded = pool.emptyMagazines;
+        pool.emptyMagazines = cache.loaded->next;
+      } else {
+        cache.loaded = newMagazine(pool);
+      }
+    }
+  }
+  cache.loaded->objects[cache.loaded->count++] = object;
+}
+
+// Expects every thread cache to be flushed
+void freePool(pool_allocator& pool) {
+  for(void* mallocPtr : pool.mallocPtrs) {
+    free(mallocPtr);
+  }
+  initPool(pool, pool.objectSize, pool.alignment, pool.objectsPerBlock);
+}
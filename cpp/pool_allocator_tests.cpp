@@ -0,0 +1,160 @@
+#include "test.h"
+#include <thread>
+#include <unordered_set>
+
+#include "pool_allocator.h"
+
+struct pool_test_node {
+  u32 data;
+  pool_test_node* next;
+  pool_test_node* prev;
+};
+
+TEST(PoolAllocator, singleThreadReuse) {
+  const u32 objectCount = 10000;
+  pool_allocator pool;
+  initPool(pool, sizeof(pool_test_node), 32);
+  ASSERT_EQ(pool.objectSize, 32);
+  pool_thread_cache cache;
+  initThreadCache(pool, cache);
+
+  std::vector<pool_test_node*> nodes(objectCount);
+  u64 totalMemoryAllocated[3];
+  for(u32 round = 0; round < 3; round++) {
+    std::unordered_set<pool_test_node*> uniqueNodes;
+    for(u32 i = 0; i < objectCount; i++) {
+      nodes[i] = (pool_test_node*)allocate(pool, cache);
+      ASSERT_EQ((uintptr_t)nodes[i] % 32, 0);
+      nodes[i]->data = i;
+      uniqueNodes.insert(nodes[i]);
+    }
+    ASSERT_EQ(uniqueNodes.size(), objectCount);
+    for(u32 i = 0; i < objectCount; i++) {
+      ASSERT_EQ(nodes[i]->data, i);
+      deallocate(pool, cache, nodes[i]);
+    }
+    totalMemoryAllocated[round] = pool.totalMemoryAllocated;
+  }
+  // the first round frees into new magazines, after that everything is reused
+  ASSERT_EQ(totalMemoryAllocated[1], totalMemoryAllocated[2]);
+
+  flushThreadCache(pool, cache);
+  freePool(pool);
+  ASSERT_EQ(pool.totalMemoryAllocated, 0);
+}
+
+TEST(PoolAllocator, freedByAnotherThread) {
+  const u32 threadCount = 4;
+  const u32 objectCountPerThread = 20000;
+  pool_allocator pool;
+  initPool(pool, sizeof(pool_test_node));
+
+  std::vector<std::vector<pool_test_node*>> threadNodes(threadCount);
+  std::vector<std::thread> threads;
+  for(u32 threadIndex = 0; threadIndex < threadCount; threadIndex++) {
+    threads.emplace_back([&, threadIndex]() {
+      pool_thread_cache cache;
+      initThreadCache(pool, cache);
+      for(u32 i = 0; i < objectCountPerThread; i++) {
+        pool_test_node* node = (pool_test_node*)allocate(pool, cache);
+        node->data = threadIndex;
+        threadNodes[threadIndex].push_back(node);
+      }
+      flushThreadCache(pool, cache);
+    });
+  }
+  for(std::thread& thread : threads) {
+    thread.join();
+  }
+  threads.clear();
+  const u8* freeObjects = pool.freeObjects;
+
+  std::atomic<u32> wrongDataCount(0);
+  for(u32 threadIndex = 0; threadIndex < threadCount; threadIndex++) {
+    threads.emplace_back([&, threadIndex]() {
+      pool_thread_cache cache;
+      initThreadCache(pool, cache);
+      const u32 ownerIndex = (threadIndex + 1) % threadCount;
+      for(pool_test_node* node : threadNodes[ownerIndex]) {
+        wrongDataCount += (node->data != ownerIndex);
+        deallocate(pool, cache, node);
+      }
+      flushThreadCache(pool, cache);
+    });
+  }
+  for(std::thread& thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(wrongDataCount.load(), 0);
+
+  // every object comes back out of the depot, none are carved from a block
+  pool_thread_cache cache;
+  initThreadCache(pool, cache);
+  std::unordered_set<void*> uniqueObjects;
+  for(u32 i = 0; i < threadCount * objectCountPerThread; i++) {
+    uniqueObjects.insert(allocate(pool, cache));
+  }
+  ASSERT_EQ(uniqueObjects.size(), threadCount * objectCountPerThread);
+  ASSERT_EQ(pool.freeObjects, freeObjects);
+  flushThreadCache(pool, cache);
+
+  freePool(pool);
+}
+
+// Each thread repeatedly allocates a batch of nodes, touches them and frees them again
+template<typename Allocate, typename Free>
+f64 timeNodeChurn(u32 threadCount, Allocate allocateFunc, Free freeFunc) {
+  const u32 roundCount = 2000;
+  const u32 batchSize = 256;
+  Timer timer;
+  StartTimer(timer);
+  std::vector<std::thread> threads;
+  for(u32 threadIndex = 0; threadIndex < threadCount; threadIndex++) {
+    threads.emplace_back([&, threadIndex]() {
+      std::vector<pool_test_node*> nodes(batchSize);
+      for(u32 round = 0; round < roundCount; round++) {
+        for(u32 i = 0; i < batchSize; i++) {
+          nodes[i] = allocateFunc(threadIndex);
+          nodes[i]->data = i;
+        }
+        for(u32 i = 0; i < batchSize; i++) {
+          freeFunc(threadIndex, nodes[i]);
+        }
+      }
+    });
+  }
+  for(std::thread& thread : threads) {
+    thread.join();
+  }
+  return StopTimer(timer);
+}
+
+TEST(PoolAllocator, performanceAgainstMallocAndNew) {
+  const u32 threadCounts[] = {1, 4};
+  for(u32 threadCount : threadCounts) {
+    f64 timeForMalloc = timeNodeChurn(threadCount,
+                                      [](u32) { return (pool_test_node*)malloc(sizeof(pool_test_node)); },
+                                      [](u32, pool_test_node* node) { free(node); });
+    printf("Time for node churn on %u threads (malloc): %5.5f ms\n", threadCount, timeForMalloc);
+
+    f64 timeForNew = timeNodeChurn(threadCount,
+                                   [](u32) { return new pool_test_node; },
+                                   [](u32, pool_test_node* node) { delete node; });
+    printf("Time for node churn on %u threads (new): %5.5f ms\n", threadCount, timeForNew);
+
+    pool_allocator pool;
+    initPool(pool, sizeof(pool_test_node));
+    std::vector<pool_thread_cache> caches(threadCount);
+    for(pool_thread_cache& cache : caches) {
+      initThreadCache(pool, cache);
+    }
+    f64 timeForPool = timeNodeChurn(threadCount,
+                                    [&](u32 threadIndex) { return (pool_test_node*)allocate(pool, caches[threadIndex]); },
+                                    [&](u32 threadIndex, pool_test_node* node) { deallocate(pool, caches[threadIndex], node); });
+    printf("Time for node churn on %u threads (pool): %5.5f ms\n", threadCount, timeForPool);
+    for(pool_thread_cache& cache : caches) {
+      flushThreadCache(pool, cache);
+    }
+    freePool(pool);
+  }
+}
@@ -3,8 +3,24 @@
 //
 
 #include "test.h"
+#include <random>
 
+#include <algorithm>
 #include <string>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
 
 /*
   Given an input string s and a pattern p, implement regular expression matching with support for '.' and '*' where:
@@ -14,142 +30,461 @@
 
   The matching should cover the entire input string (not partial).
  */
-class Solution {
-public:
 
-  // This function WILL NOT handle the ".*" case
-  // Sending in a string with ".*" is undefined
-  // if match found, returns one index after the last character in the found substring
-  // if match not found, returns -1
-  bool matchingSubstr(const std::string& s, size_t strBegin, size_t strEnd,
-                      const std::string& p, size_t patBegin, size_t patEnd,
-                      s32& outSubstrBegin, s32& outSubstrEnd) {
-
-    outSubstrBegin = -1;
-    outSubstrEnd = -1;
-
-    s32 lastPatIndex = (s32)patEnd - 1;
-
-    for(s32 startStrIndex = (s32)strBegin; startStrIndex < strEnd; ++startStrIndex) {
-      s32 sIter = startStrIndex;
-      for(s32 patIndex = (s32)patBegin; patIndex < patEnd; ++patIndex) {
-
-        char patC = p[patIndex];
-        bool zeroToMany = ((patIndex + 1) < patEnd) && p[patIndex + 1] == '*';
-
-        if(zeroToMany) {
-          ++patIndex;
-
-          while(sIter < strEnd) {
-            char c = s[sIter];
-            if(c == patC) {
-              ++sIter;
-            } else {
-              break;
-            }
-          }
-        } else if(sIter >= strEnd) { // if string iteration has gone to far, no matching substring found
-          return false;
-        } else if(patC == '.') {
-          // Keep going
-          ++sIter;
-        } else if(patC != s[sIter]) {
-          break; // break this pattern match loop
-        }
+// massage the pattern
+// a substring of "a*aaa" would preferably be "aaaa*", both say "three or more consecutive a's"
+// a substring of "aa*aaaa*aaa" would preferably be "aaaaaaaa*", "7 or more consecutive a's"
+// return result is the new length of the pattern
+s32 massagePattern(std::string& p) {
+  size_t pLen = p.length();
 
-        if(patIndex == lastPatIndex) { // pattern has finished, end of matching substring is
-          outSubstrBegin = startStrIndex;
-          outSubstrEnd = sIter;
-          return true;
+  char repeatedChar;
+  size_t moveBack = 0; // occurs when two '*' cancel out
+  for(size_t i = 1; i < pLen; ++i) { // constraints mention that '*' will never be at index 0
+    const char c = p[i];
+    p[i - moveBack] = c;
+    if(c == '*') {
+      repeatedChar = p[i-1];
+      size_t nextIndex = i + 1;
+      while(nextIndex < pLen) {
+        if (p[nextIndex] == '*') { // another star
+          moveBack += 2;
+        } else if(p[nextIndex] == repeatedChar) {
+          p[nextIndex - moveBack - 1] = repeatedChar;
+        } else {
+          break;
         }
+        ++nextIndex;
       }
+      i = nextIndex - 1;
+      p[i - moveBack] = '*';
     }
+  }
 
-    return false;
+  return pLen - moveBack;
+}
+
+// ==== COMPILED PATTERN
+// The pattern is a sequence of elements, each a byte or '.' and optionally starred. NFA state i has matched the first
+// i elements and state elementCount accepts. Sets of NFA states are bitsets and are kept epsilon closed: a starred
+// element can be skipped, so a set holding i also holds i + 1 when element i is starred.
+// The DFA is built lazily by subset construction. A DFA state is one closed set of NFA states, and each transition is
+// computed the first time it is taken and then cached, so matching costs one table lookup per input byte once the
+// states it needs exist. Bytes that no element names literally all behave alike and share byte class 0, which keeps
+// each state's row of transitions short. When the state cache fills it is flushed and matching carries on from the
+// state being added, so memory is only allocated by compileRegex().
+
+const u32 regexUnknownState = U32_MAX;
+const u32 regexDeadState = 0; // the empty set, nothing can match from here
+const u32 regexDefaultStateCapacity = 1024;
+
+struct regex_dfa {
+  std::string elementChars; // '.' matches any byte
+  std::vector<u8> elementStarred;
+  u32 elementCount;
+  u32 wordCount; // u64 words in an NFA state set
+  u16 byteClass[256];
+  u8 classByte[257]; // a byte of each class
+  u32 classCount;
+
+  std::vector<u64> stateSets; // wordCount words per DFA state
+  std::vector<u32> transitions; // classCount per DFA state, regexUnknownState until taken
+  std::vector<u8> accepting;
+  std::vector<u32> stateTable; // open addressing from state set to DFA state index + 1, 0 when empty
+  std::vector<u64> scratchSet;
+  std::vector<u64> startSet;
+  std::vector<u64> deadSet;
+  u32 startState;
+  u32 stateCount;
+  u32 stateCapacity;
+  u32 cacheFlushCount;
+};
+
+u32 regexCountTrailingZeros(u64 value) {
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward64(&index, value);
+  return index;
+#else
+  return __builtin_ctzll(value);
+#endif
+}
+
+u64 regexStateSetHash(const u64* set, u32 wordCount) {
+  u64 hash = 0xcbf29ce484222325ull;
+  for(u32 i = 0; i < wordCount; i++) {
+    hash = (hash ^ set[i]) * 0x100000001b3ull;
+    hash ^= hash >> 32;
   }
+  return hash;
+}
 
-  // massage the pattern
-  // a substring of "a*aaa" would preferably be "aaaa*", both say "three or more consecutive a's"
-  // a substring of "aa*aaaa*aaa" would preferably be "aaaaaaaa*", "7 or more consecutive a's"
-  // return result is the new length of the pattern
-  s32 massagePattern(std::string& p) {
-    size_t pLen = p.length();
-
-    char repeatedChar;
-    size_t moveBack = 0; // occurs when two '*' cancel out
-    for(size_t i = 1; i < pLen; ++i) { // constraints mention that '*' will never be at index 0
-      const char c = p[i];
-      p[i - moveBack] = c;
-      if(c == '*') {
-        repeatedChar = p[i-1];
-        size_t nextIndex = i + 1;
-        while(nextIndex < pLen) {
-          if (p[nextIndex] == '*') { // another star
-            moveBack += 2;
-          } else if(p[nextIndex] == repeatedChar) {
-            p[nextIndex - moveBack - 1] = repeatedChar;
-          } else {
-            break;
-          }
-          ++nextIndex;
-        }
-        i = nextIndex - 1;
-        p[i - moveBack] = '*';
+// Adds nfaState and every state after it reached by skipping starred elements
+void addClosed(const regex_dfa& dfa, u64* set, u32 nfaState) {
+  while(true) {
+    set[nfaState / 64] |= 1ull << (nfaState % 64);
+    if(nfaState == dfa.elementCount || !dfa.elementStarred[nfaState]) {
+      return;
+    }
+    ++nfaState;
+  }
+}
+
+// Returns regexUnknownState when the set is new and the cache is full
+u32 findOrAddState(regex_dfa& dfa, const u64* set) {
+  const u64 mask = dfa.stateTable.size() - 1;
+  u64 slot = regexStateSetHash(set, dfa.wordCount) & mask;
+  while(dfa.stateTable[slot] != 0) {
+    const u32 state = dfa.stateTable[slot] - 1;
+    if(memcmp(&dfa.stateSets[(u64)state * dfa.wordCount], set, dfa.wordCount * sizeof(u64)) == 0) {
+      return state;
+    }
+    slot = (slot + 1) & mask;
+  }
+  if(dfa.stateCount == dfa.stateCapacity) {
+    return regexUnknownState;
+  }
+
+  const u32 state = dfa.stateCount++;
+  memcpy(&dfa.stateSets[(u64)state * dfa.wordCount], set, dfa.wordCount * sizeof(u64));
+  u32* row = &dfa.transitions[(u64)state * dfa.classCount];
+  for(u32 i = 0; i < dfa.classCount; i++) {
+    row[i] = (state == regexDeadState) ? regexDeadState : regexUnknownState;
+  }
+  dfa.accepting[state] = (set[dfa.elementCount / 64] >> (dfa.elementCount % 64)) & 1;
+  dfa.stateTable[slot] = state + 1;
+  return state;
+}
+
+// Forgets every DFA state but the dead and start states
+void flushStates(regex_dfa& dfa) {
+  std::fill(dfa.stateTable.begin(), dfa.stateTable.end(), 0);
+  dfa.stateCount = 0;
+  findOrAddState(dfa, dfa.deadSet.data());
+  dfa.startState = findOrAddState(dfa, dfa.startSet.data());
+}
+
+// p must only use '.' and '*', with every '*' following a byte or '.'
+// stateCapacity bounds the DFA states cached at once, it is at least 3 so a dead, start and current state fit
+void compileRegex(regex_dfa& dfa, const std::string& p, u32 stateCapacity = regexDefaultStateCapacity) {
+  dfa.elementChars.clear();
+  dfa.elementStarred.clear();
+  for(size_t i = 0; i < p.length(); i++) {
+    Assert(p[i] != '*');
+    const bool starred = (i + 1 < p.length()) && p[i + 1] == '*';
+    dfa.elementChars.push_back(p[i]);
+    dfa.elementStarred.push_back(starred);
+    i += starred;
+  }
+  dfa.elementCount = (u32)dfa.elementChars.length();
+  dfa.wordCount = dfa.elementCount / 64 + 1;
+
+  memset(dfa.byteClass, 0, sizeof(dfa.byteClass));
+  dfa.classCount = 1;
+  for(char c : dfa.elementChars) {
+    if(c != '.' && dfa.byteClass[(u8)c] == 0) {
+      dfa.classByte[dfa.classCount] = (u8)c;
+      dfa.byteClass[(u8)c] = (u16)dfa.classCount++;
+    }
+  }
+  dfa.classByte[0] = 0;
+  for(u32 byte = 0; byte < 256; byte++) {
+    if(dfa.byteClass[byte] == 0) {
+      dfa.classByte[0] = (u8)byte;
+      break;
+    }
+  }
+
+  dfa.stateCapacity = MAX(stateCapacity, 3);
+  u64 tableSize = 1;
+  while(tableSize < (u64)dfa.stateCapacity * 2) {
+    tableSize <<= 1;
+  }
+  dfa.stateSets.assign((u64)dfa.stateCapacity * dfa.wordCount, 0);
+  dfa.transitions.assign((u64)dfa.stateCapacity * dfa.classCount, regexUnknownState);
+  dfa.accepting.assign(dfa.stateCapacity, 0);
+  dfa.stateTable.assign(tableSize, 0);
+  dfa.scratchSet.assign(dfa.wordCount, 0);
+  dfa.startSet.assign(dfa.wordCount, 0);
+  dfa.deadSet.assign(dfa.wordCount, 0);
+  addClosed(dfa, dfa.startSet.data(), 0);
+  dfa.cacheFlushCount = 0;
+  flushStates(dfa);
+}
+
+// Subset construction for one transition, cached unless the cache had to be flushed
+u32 computeTransition(regex_dfa& dfa, u32 state, u8 byte) {
+  u64* nextSet = dfa.scratchSet.data();
+  memset(nextSet, 0, dfa.wordCount * sizeof(u64));
+  const u64* set = &dfa.stateSets[(u64)state * dfa.wordCount];
+  for(u32 wordIndex = 0; wordIndex < dfa.wordCount; wordIndex++) {
+    u64 bits = set[wordIndex];
+    while(bits != 0) {
+      const u32 nfaState = wordIndex * 64 + regexCountTrailingZeros(bits);
+      bits &= bits - 1;
+      if(nfaState == dfa.elementCount) {
+        continue;
+      }
+      const char c = dfa.elementChars[nfaState];
+      if(c == '.' || (u8)c == byte) {
+        addClosed(dfa, nextSet, dfa.elementStarred[nfaState] ? nfaState : nfaState + 1);
       }
     }
+  }
 
-    return pLen - moveBack;
+  u32 nextState = findOrAddState(dfa, nextSet);
+  if(nextState == regexUnknownState) {
+    flushStates(dfa); // invalidates state, nextSet lives outside the cache
+    ++dfa.cacheFlushCount;
+    nextState = findOrAddState(dfa, nextSet);
+  } else {
+    dfa.transitions[(u64)state * dfa.classCount + dfa.byteClass[byte]] = nextState;
   }
+  return nextState;
+}
 
-  bool isMatch(std::string s, std::string p) {
-    u32 sLen = s.length();
-    u32 pLen = massagePattern(p);
+// Whole string match. Stops early once no match is possible.
+bool matches(regex_dfa& dfa, const char* s, u64 length) {
+  u32 state = dfa.startState;
+  for(u64 i = 0; i < length; i++) {
+    const u8 byte = (u8)s[i];
+    u32 nextState = dfa.transitions[(u64)state * dfa.classCount + dfa.byteClass[byte]];
+    if(nextState == regexUnknownState) {
+      nextState = computeTransition(dfa, state, byte);
+    }
+    if(nextState == regexDeadState) {
+      return false;
+    }
+    state = nextState;
+  }
+  return dfa.accepting[state];
+}
 
-    s32 lastSubstrEnd = 0;
-    size_t pBegin = 0;
-    char prevPChar = '?';
-    bool beginningMatch = true;
-    for(u32 pIndex = 0; pIndex < pLen; ++pIndex) {
-      const char pChar = p[pIndex];
+bool matches(regex_dfa& dfa, std::string_view s) {
+  return matches(dfa, s.data(), s.length());
+}
 
-      if(pChar == '*' && prevPChar == '.') { // special wild card case
-        s32 substrBegin, substrEnd;
-        bool matchFound = matchingSubstr(s, lastSubstrEnd, sLen,
-                                         p, pBegin, pIndex - 1,
-                                         substrBegin, substrEnd);
-        if(!matchFound) {
+// Takes every transition from every reachable state, so matching never has to compute one. Returns false, leaving a
+// flushed but usable lazy DFA, when the states don't all fit in the cache.
+bool buildAllStates(regex_dfa& dfa) {
+  const u32 cacheFlushCount = dfa.cacheFlushCount;
+  for(u32 state = 0; state < dfa.stateCount; state++) {
+    for(u32 byteClass = 0; byteClass < dfa.classCount; byteClass++) {
+      const u8 byte = dfa.classByte[byteClass];
+      if(dfa.byteClass[byte] != byteClass) { // every byte is named by the pattern, class 0 is empty
+        continue;
+      }
+      if(dfa.transitions[(u64)state * dfa.classCount + byteClass] == regexUnknownState) {
+        computeTransition(dfa, state, byte);
+        if(dfa.cacheFlushCount != cacheFlushCount) {
           return false;
         }
+      }
+    }
+  }
+  return true;
+}
 
-        if(beginningMatch) {
-          if(substrBegin != 0) {
-            return false;
-          }
-          beginningMatch = false;
-        }
-        pBegin = pIndex + 1;
-        lastSubstrEnd = substrEnd;
+// Only for a DFA with every state built, it is only read so any number of threads can share it
+bool matchesBuilt(const regex_dfa& dfa, const char* s, u64 length) {
+  const u32* transitions = dfa.transitions.data();
+  const u16* byteClass = dfa.byteClass;
+  const u64 classCount = dfa.classCount;
+  u32 state = dfa.startState;
+  for(u64 i = 0; i < length; i++) {
+    state = transitions[state * classCount + byteClass[(u8)s[i]]];
+    if(state == regexDeadState) {
+      return false;
+    }
+  }
+  return dfa.accepting[state];
+}
+
+// ==== LITERAL PREFILTER
+// Every unstarred literal element takes part in a match, and a run of them matches as one contiguous substring, so a
+// matching input holds each such run in pattern order without overlap. Finding those runs with a SIMD substring
+// search rejects most inputs in a fraction of the time the DFA takes to walk them.
+// The search compares a broadcast of the needle's first byte at every offset and of its last byte needleLength - 1
+// further on, and only candidates where both match get a full compare.
+
+const u64 substringNotFound = U64_MAX;
+
+u64 findSubstring(const char* s, u64 length, const char* needle, u64 needleLength) {
+  if(needleLength == 0) {
+    return 0;
+  }
+  if(needleLength > length) {
+    return substringNotFound;
+  }
+  const u64 startCount = length - needleLength + 1;
+  const u64 lastOffset = needleLength - 1;
+  u64 i = 0;
+#if defined(__AVX2__)
+  const __m256i first = _mm256_set1_epi8(needle[0]);
+  const __m256i last = _mm256_set1_epi8(needle[lastOffset]);
+  for(; i + 32 <= startCount; i += 32) {
+    const __m256i firstMatches = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(s + i)), first);
+    const __m256i lastMatches = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(s + i + lastOffset)), last);
+    u32 candidates = (u32)_mm256_movemask_epi8(_mm256_and_si256(firstMatches, lastMatches));
+#elif defined(__SSE2__) || defined(_M_X64)
+  const __m128i first = _mm_set1_epi8(needle[0]);
+  const __m128i last = _mm_set1_epi8(needle[lastOffset]);
+  for(; i + 16 <= startCount; i += 16) {
+    const __m128i firstMatches = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(s + i)), first);
+    const __m128i lastMatches = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(s + i + lastOffset)), last);
+    u32 candidates = (u32)_mm_movemask_epi8(_mm_and_si128(firstMatches, lastMatches));
+#endif
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+    while(candidates != 0) {
+      const u64 start = i + regexCountTrailingZeros(candidates);
+      if(needleLength <= 2 || memcmp(s + start + 1, needle + 1, needleLength - 2) == 0) {
+        return start;
       }
+      candidates &= candidates - 1;
+    }
+  }
+#endif
+  for(; i < startCount; i++) {
+    if(s[i] == needle[0] && memcmp(s + i, needle, needleLength) == 0) {
+      return i;
+    }
+  }
+  return substringNotFound;
+}
 
-      prevPChar = pChar;
+// The runs of unstarred literal elements, in order, and the shortest input that could match
+void extractRequiredLiterals(const regex_dfa& dfa, std::vector<std::string>& outLiterals, u64& outMinLength) {
+  outLiterals.clear();
+  outMinLength = 0;
+  std::string run;
+  for(u32 i = 0; i <= dfa.elementCount; i++) {
+    const bool literal = i < dfa.elementCount && !dfa.elementStarred[i] && dfa.elementChars[i] != '.';
+    if(literal) {
+      run += dfa.elementChars[i];
+    } else if(!run.empty()) {
+      outLiterals.push_back(run);
+      run.clear();
     }
+    outMinLength += (i < dfa.elementCount && !dfa.elementStarred[i]);
+  }
+}
+
+// ==== COMPILED PATTERN OBJECTS
+// A pattern massaged and compiled once, for matching against any number of inputs. When the whole DFA fits in
+// stateCapacity states it is built up front and matching only reads it, without allocating. Otherwise every thread needs
+// its own copy of the lazy DFA to build states in. A CompiledPatternScratch keeps those copies, and the states they
+// built, from one matchAll() call to the next; without one each call copies the DFA once per thread.
+// Inputs are first checked for the required literals when the pattern has a starred '.'. Without one the DFA usually
+// reaches its dead state within a few bytes of a non-matching input, and a prefilter scanning the whole input costs
+// more than it saves.
+
+struct CompiledPattern {
+  std::string pattern; // massaged
+  regex_dfa dfa;
+  bool allStatesBuilt;
+  std::vector<std::string> requiredLiterals;
+  u64 minLength;
+  bool usePrefilter;
+
+  CompiledPattern(std::string p, u32 stateCapacity = regexDefaultStateCapacity) {
+    p.resize(massagePattern(p));
+    pattern = p;
+    compileRegex(dfa, pattern, stateCapacity);
+    allStatesBuilt = buildAllStates(dfa);
+    extractRequiredLiterals(dfa, requiredLiterals, minLength);
+    usePrefilter = !requiredLiterals.empty() && pattern.find(".*") != std::string::npos;
+  }
+};
 
-    s32 substrBegin, substrEnd;
-    bool matchFound = matchingSubstr(s, lastSubstrEnd, sLen,
-                                     p, pBegin, pLen,
-                                     substrBegin, substrEnd);
-    if(!matchFound) {
+// Per thread copies of a lazy DFA, see matchAll(). Only for the pattern it was first used with.
+struct CompiledPatternScratch {
+  const CompiledPattern* pattern = nullptr;
+  std::vector<regex_dfa> dfas; // one per thread
+};
+
+// False when s can't match, true when it might
+bool passesPrefilter(const CompiledPattern& pattern, const char* s, u64 length) {
+  if(length < pattern.minLength) {
+    return false;
+  }
+  u64 offset = 0;
+  for(const std::string& literal : pattern.requiredLiterals) {
+    const u64 index = findSubstring(s + offset, length - offset, literal.data(), literal.length());
+    if(index == substringNotFound) {
       return false;
     }
+    offset += index + literal.length();
+  }
+  return true;
+}
 
-    if(beginningMatch) {
-      if(substrBegin != 0) {
-        return false;
-      }
-      beginningMatch = false;
+// lazyDfa is the calling thread's copy of the DFA, nullptr when all states are built
+void matchRange(const CompiledPattern& pattern, regex_dfa* lazyDfa, const std::string_view* inputs, u64 begin, u64 end,
+                bool* out) {
+  if(pattern.allStatesBuilt) {
+    for(u64 i = begin; i < end; i++) {
+      out[i] = (!pattern.usePrefilter || passesPrefilter(pattern, inputs[i].data(), inputs[i].length())) &&
+               matchesBuilt(pattern.dfa, inputs[i].data(), inputs[i].length());
     }
+  } else {
+    for(u64 i = begin; i < end; i++) {
+      out[i] = (!pattern.usePrefilter || passesPrefilter(pattern, inputs[i].data(), inputs[i].length())) &&
+               matches(*lazyDfa, inputs[i].data(), inputs[i].length());
+    }
+  }
+}
+
+// out[i] is whether inputs[i] matches. With threadCount > 1 the inputs are split into contiguous ranges, one per
+// thread. Nothing is allocated per input, and with a pattern whose states are all built, nothing at all. A lazy
+// pattern's DFA is copied into scratch once for each thread that hasn't got a copy from an earlier call yet.
+void matchAll(const CompiledPattern& pattern, CompiledPatternScratch& scratch, const std::string_view* inputs, u64 count,
+              bool* out, u32 threadCount = 1) {
+  Assert(scratch.pattern == nullptr || scratch.pattern == &pattern);
+  scratch.pattern = &pattern;
+  threadCount = (u32)MAX(MIN((u64)threadCount, count), 1);
+  if(!pattern.allStatesBuilt && scratch.dfas.size() < threadCount) {
+    scratch.dfas.resize(threadCount, pattern.dfa);
+  }
+  if(threadCount == 1) {
+    matchRange(pattern, pattern.allStatesBuilt ? nullptr : scratch.dfas.data(), inputs, 0, count, out);
+    return;
+  }
+
+  std::vector<std::thread> threads;
+  threads.reserve(threadCount);
+  for(u32 threadIndex = 0; threadIndex < threadCount; threadIndex++) {
+    const u64 begin = count * threadIndex / threadCount;
+    const u64 end = count * (threadIndex + 1) / threadCount;
+    regex_dfa* lazyDfa = pattern.allStatesBuilt ? nullptr : &scratch.dfas[threadIndex];
+    threads.emplace_back(matchRange, std::cref(pattern), lazyDfa, inputs, begin, end, out);
+  }
+  for(std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+// Copies a lazy pattern's DFA for this call only
+void matchAll(const CompiledPattern& pattern, const std::string_view* inputs, u64 count, bool* out, u32 threadCount = 1) {
+  CompiledPatternScratch scratch;
+  matchAll(pattern, scratch, inputs, count, out, threadCount);
+}
+
+bool matches(const CompiledPattern& pattern, std::string_view s) {
+  bool out;
+  matchAll(pattern, &s, 1, &out);
+  return out;
+}
 
-    return true;
+class Solution {
+public:
+
+  // One off match, a CompiledPattern is better for matching many strings against the same pattern
+  bool isMatch(const std::string& s, std::string p) {
+    p.resize(massagePattern(p));
+    regex_dfa dfa;
+    // a match visits at most one new state per byte, besides the dead and start states
+    compileRegex(dfa, p, (u32)MIN((u64)regexDefaultStateCapacity, s.length() + 2));
+    return matches(dfa, s);
   }
 };
 
@@ -166,5 +501,240 @@ TEST(Playground, regex) {
 
   bool substrMatch = solution.isMatch(str2, pattern2);
 
-  ASSERT_TRUE(substrMatch);
-}
\ No newline at end of file
+  ASSERT_FALSE(substrMatch); // the whole string has to match
+  ASSERT_TRUE(solution.isMatch(str1, pattern1));
+}
+
+// Plain recursive backtracking, exponential in the number of stars in the worst case
+bool isMatchBacktracking(const char* s, const char* p) {
+  if(*p == '\0') {
+    return *s == '\0';
+  }
+  const bool firstMatches = *s != '\0' && (*p == '.' || *p == *s);
+  if(p[1] == '*') {
+    return isMatchBacktracking(s, p + 2) || (firstMatches && isMatchBacktracking(s + 1, p));
+  }
+  return firstMatches && isMatchBacktracking(s + 1, p + 1);
+}
+
+TEST(Playground, regexAgainstBacktracking) {
+  std::mt19937 randomGenerator(48);
+  Solution solution;
+  u32 matchCount = 0;
+  for(u32 i = 0; i < 20000; i++) {
+    std::string p;
+    const u32 elementCount = randomGenerator() % 8;
+    for(u32 j = 0; j < elementCount; j++) {
+      p += "ab."[randomGenerator() % 3];
+      if(randomGenerator() % 2 == 0) {
+        p += '*';
+      }
+    }
+    std::string s;
+    const u32 sLength = randomGenerator() % 10;
+    for(u32 j = 0; j < sLength; j++) {
+      s += "abc"[randomGenerator() % 3];
+    }
+    const bool expected = isMatchBacktracking(s.c_str(), p.c_str());
+    ASSERT_EQ(solution.isMatch(s, p), expected) << "s: " << s << " p: " << p;
+    matchCount += expected;
+  }
+  ASSERT_GT(matchCount, 1000);
+
+  // a tiny cache is flushed constantly and still gives the same answers
+  regex_dfa dfa;
+  compileRegex(dfa, "a.*b.*a*.c*.*ab", 3);
+  for(u32 i = 0; i < 2000; i++) {
+    std::string s;
+    const u32 sLength = randomGenerator() % 16;
+    for(u32 j = 0; j < sLength; j++) {
+      s += "abc"[randomGenerator() % 3];
+    }
+    ASSERT_EQ(matches(dfa, s), isMatchBacktracking(s.c_str(), "a.*b.*a*.c*.*ab")) << "s: " << s;
+  }
+  ASSERT_GT(dfa.cacheFlushCount, 0);
+}
+
+TEST(Playground, regexPerformanceAgainstBacktracking) {
+  // every '.*' can end anywhere, backtracking tries every combination before failing on the last 'b'
+  const std::string p = "a.*a.*a.*a.*a.*b";
+  const u32 lengths[] = {25, 50, 100};
+  regex_dfa dfa;
+  compileRegex(dfa, p);
+  for(u32 length : lengths) {
+    const std::string s(length, 'a');
+    Timer timer;
+    StartTimer(timer);
+    bool backtrackingMatch = isMatchBacktracking(s.c_str(), p.c_str());
+    f64 timeForBacktracking = StopTimer(timer);
+    StartTimer(timer);
+    bool dfaMatch = matches(dfa, s);
+    f64 timeForDfa = StopTimer(timer);
+    printf("Time to reject %u chars (backtracking): %5.5f ms\n", length, timeForBacktracking);
+    printf("Time to reject %u chars (lazy DFA): %5.5f ms\n", length, timeForDfa);
+    ASSERT_FALSE(backtrackingMatch);
+    ASSERT_FALSE(dfaMatch);
+  }
+
+  const std::string longString = std::string(1 << 24, 'a') + "b";
+  Timer timer;
+  StartTimer(timer);
+  bool dfaMatch = matches(dfa, longString);
+  f64 timeForDfa = StopTimer(timer);
+  printf("Time to match %zu chars (lazy DFA): %5.5f ms, %u DFA states\n", longString.length(), timeForDfa,
+         dfa.stateCount);
+  ASSERT_TRUE(dfaMatch);
+}
+
+TEST(Playground, regexCompiledPattern) {
+  const char* p = "a.*b.*a*.c*.*ab";
+  std::mt19937 randomGenerator(49);
+  std::vector<std::string> inputs(5000);
+  for(std::string& s : inputs) {
+    const u32 sLength = randomGenerator() % 16;
+    for(u32 j = 0; j < sLength; j++) {
+      s += "abc"[randomGenerator() % 3];
+    }
+  }
+  std::vector<std::string_view> inputViews(inputs.begin(), inputs.end());
+
+  CompiledPattern builtPattern(p);
+  CompiledPattern lazyPattern(p, 3);
+  ASSERT_TRUE(builtPattern.allStatesBuilt);
+  ASSERT_FALSE(lazyPattern.allStatesBuilt);
+  CompiledPatternScratch lazyScratch;
+  const u32 threadCounts[] = {1, 4};
+  for(u32 threadCount : threadCounts) {
+    std::unique_ptr<bool[]> builtOut(new bool[inputs.size()]);
+    std::unique_ptr<bool[]> lazyOut(new bool[inputs.size()]);
+    std::unique_ptr<bool[]> scratchOut(new bool[inputs.size()]);
+    matchAll(builtPattern, inputViews.data(), inputViews.size(), builtOut.get(), threadCount);
+    matchAll(lazyPattern, inputViews.data(), inputViews.size(), lazyOut.get(), threadCount);
+    matchAll(lazyPattern, lazyScratch, inputViews.data(), inputViews.size(), scratchOut.get(), threadCount);
+    ASSERT_EQ(lazyScratch.dfas.size(), threadCount); // only copied for threads that had no copy yet
+    for(u64 i = 0; i < inputs.size(); i++) {
+      const bool expected = isMatchBacktracking(inputs[i].c_str(), p);
+      ASSERT_EQ(builtOut[i], expected) << "s: " << inputs[i];
+      ASSERT_EQ(lazyOut[i], expected) << "s: " << inputs[i];
+      ASSERT_EQ(scratchOut[i], expected) << "s: " << inputs[i];
+    }
+  }
+
+  CompiledPattern emptyPattern("");
+  ASSERT_TRUE(matches(emptyPattern, ""));
+  ASSERT_FALSE(matches(emptyPattern, "a"));
+}
+
+TEST(Playground, regexMatchAllPerformance) {
+  const u32 lineCount = 1 << 20;
+  const char* words[] = {"INFO", "WARN", "ERROR", "request", "timeout", "connection", "user", "id=42", "ok", "retry"};
+  std::mt19937 randomGenerator(49);
+  std::vector<std::string> lines(lineCount);
+  for(std::string& line : lines) {
+    const u32 wordCount = 6 + randomGenerator() % 10;
+    for(u32 i = 0; i < wordCount; i++) {
+      line += words[randomGenerator() % ArrayCount(words)];
+      line += ' ';
+    }
+  }
+  std::vector<std::string_view> lineViews(lines.begin(), lines.end());
+  const std::string p = ".*ERROR.*timeout.*retry.*";
+  std::unique_ptr<bool[]> out(new bool[lineCount]);
+
+  Solution solution;
+  Timer timer;
+  StartTimer(timer);
+  u64 isMatchCount = 0;
+  for(const std::string& line : lines) {
+    isMatchCount += solution.isMatch(line, p);
+  }
+  f64 timeForIsMatch = StopTimer(timer);
+  printf("Time to match %u lines (Solution::isMatch): %5.5f ms\n", lineCount, timeForIsMatch);
+
+  StartTimer(timer);
+  CompiledPattern pattern(p);
+  f64 timeForCompile = StopTimer(timer);
+  printf("Time to compile pattern: %5.5f ms, %u DFA states\n", timeForCompile, pattern.dfa.stateCount);
+
+  const u32 threadCounts[] = {1, 4};
+  for(u32 threadCount : threadCounts) {
+    StartTimer(timer);
+    matchAll(pattern, lineViews.data(), lineCount, out.get(), threadCount);
+    f64 timeForMatchAll = StopTimer(timer);
+    printf("Time to match %u lines (matchAll, %u threads): %5.5f ms\n", lineCount, threadCount, timeForMatchAll);
+    u64 matchAllCount = 0;
+    for(u32 i = 0; i < lineCount; i++) {
+      matchAllCount += out[i];
+    }
+    ASSERT_EQ(matchAllCount, isMatchCount);
+  }
+  ASSERT_GT(isMatchCount, 0);
+}
+
+TEST(Playground, regexRequiredLiterals) {
+  CompiledPattern pattern("a*aaab.*cd.e");
+  ASSERT_EQ(pattern.pattern, "aaaa*b.*cd.e");
+  ASSERT_EQ(pattern.requiredLiterals, std::vector<std::string>({"aaa", "b", "cd", "e"}));
+  ASSERT_EQ(pattern.minLength, 8);
+  ASSERT_TRUE(pattern.usePrefilter);
+  ASSERT_TRUE(passesPrefilter(pattern, "aaabcdxe", 8));
+  ASSERT_FALSE(passesPrefilter(pattern, "aaabcdxe", 7));
+  ASSERT_FALSE(passesPrefilter(pattern, "aaacdbxe", 8)); // out of order
+  ASSERT_FALSE(CompiledPattern("a.b*c").usePrefilter);
+
+  std::mt19937 randomGenerator(50);
+  for(u32 i = 0; i < 20000; i++) {
+    std::string s;
+    const u32 sLength = randomGenerator() % 100;
+    for(u32 j = 0; j < sLength; j++) {
+      s += "abc"[randomGenerator() % 3];
+    }
+    std::string needle;
+    const u32 needleLength = 1 + randomGenerator() % 6;
+    for(u32 j = 0; j < needleLength; j++) {
+      needle += "abc"[randomGenerator() % 3];
+    }
+    const size_t expected = s.find(needle);
+    const u64 index = findSubstring(s.data(), s.length(), needle.data(), needle.length());
+    ASSERT_EQ(index, expected == std::string::npos ? substringNotFound : expected) << "s: " << s << " needle: " << needle;
+  }
+}
+
+TEST(Playground, regexPrefilterPerformance) {
+  const u32 lineCount = 1 << 20;
+  const char* words[] = {"INFO", "WARN", "ERROR", "request", "timeout", "connection", "user", "id=42", "ok", "retry"};
+  std::mt19937 randomGenerator(50);
+  std::vector<std::string> lines(lineCount);
+  for(std::string& line : lines) {
+    const u32 wordCount = 6 + randomGenerator() % 10;
+    for(u32 i = 0; i < wordCount; i++) {
+      line += words[randomGenerator() % ArrayCount(words)];
+      line += ' ';
+    }
+  }
+  std::vector<std::string_view> lineViews(lines.begin(), lines.end());
+  std::unique_ptr<bool[]> out(new bool[lineCount]);
+
+  const char* patterns[] = {".*ERROR timeout retry.*", ".*ERROR.*timeout.*retry.*", ".*ok .*"};
+  for(const char* p : patterns) {
+    CompiledPattern pattern(p);
+    ASSERT_TRUE(pattern.usePrefilter);
+    u64 matchCounts[2];
+    f64 times[2];
+    for(u32 prefilter = 0; prefilter < 2; prefilter++) {
+      pattern.usePrefilter = prefilter;
+      Timer timer;
+      StartTimer(timer);
+      matchAll(pattern, lineViews.data(), lineCount, out.get());
+      times[prefilter] = StopTimer(timer);
+      matchCounts[prefilter] = 0;
+      for(u32 i = 0; i < lineCount; i++) {
+        matchCounts[prefilter] += out[i];
+      }
+    }
+    printf("Time to match %u lines against \"%s\" (DFA only): %5.5f ms\n", lineCount, p, times[0]);
+    printf("Time to match %u lines against \"%s\" (literal prefilter): %5.5f ms, %5.2f%% matched\n", lineCount, p,
+           times[1], 100.0 * matchCounts[1] / lineCount);
+    ASSERT_EQ(matchCounts[0], matchCounts[1]);
+  }
+}
@@ -4,11 +4,35 @@
 
 #include <chrono>
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 struct Timer {
   std::chrono::steady_clock::time_point prev;
   f64 delta;
 };
+
+// Read-only view of a file mapped straight into memory, no copy into a buffer and no zero filling first
+struct MappedFile {
+  const char* data;
+  u64 size;
+#ifdef _WIN32
+  HANDLE fileHandle;
+  HANDLE mappingHandle;
+#endif
+};
+
 void readFile(const char* filePath, std::vector<char>& fileBytes);
+bool mapFile(const char* filePath, MappedFile& outMappedFile);
+void unmapFile(MappedFile& mappedFile);
 
 // Returns time in milliseconds
 void StartTimer(Timer& timer);
@@ -35,6 +59,88 @@ void readFile(const char* filePath, std::vector<char>& fileBytes) {
   file.close();
 }
 
+// The mapping is hinted for one sequential pass and asked to start reading ahead immediately
+bool mapFile(const char* filePath, MappedFile& outMappedFile) {
+  outMappedFile = {};
+
+#ifdef _WIN32
+  HANDLE fileHandle = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if(fileHandle == INVALID_HANDLE_VALUE) {
+    std::cout << "Could not open file: " << filePath << std::endl;
+    return false;
+  }
+
+  LARGE_INTEGER fileSize;
+  if(!GetFileSizeEx(fileHandle, &fileSize)) {
+    std::cout << "Could not read the size of file: " << filePath << std::endl;
+    CloseHandle(fileHandle);
+    return false;
+  }
+  if(fileSize.QuadPart == 0) { // empty files can't be mapped
+    CloseHandle(fileHandle);
+    return true;
+  }
+
+  HANDLE mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  void* data = (mappingHandle == nullptr) ? nullptr : MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+  if(data == nullptr) {
+    std::cout << "Could not map file: " << filePath << std::endl;
+    if(mappingHandle != nullptr) { CloseHandle(mappingHandle); }
+    CloseHandle(fileHandle);
+    return false;
+  }
+
+  outMappedFile.data = (const char*)data;
+  outMappedFile.size = fileSize.QuadPart;
+  outMappedFile.fileHandle = fileHandle;
+  outMappedFile.mappingHandle = mappingHandle;
+#else
+  int fileDescriptor = open(filePath, O_RDONLY);
+  if(fileDescriptor == -1) {
+    std::cout << "Could not open file: " << filePath << std::endl;
+    return false;
+  }
+
+  struct stat fileStat;
+  if(fstat(fileDescriptor, &fileStat) == -1) {
+    std::cout << "Could not read the size of file: " << filePath << std::endl;
+    close(fileDescriptor);
+    return false;
+  }
+  if(fileStat.st_size == 0) { // empty files can't be mapped
+    close(fileDescriptor);
+    return true;
+  }
+
+  void* data = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+  close(fileDescriptor); // the mapping keeps the file open
+  if(data == MAP_FAILED) {
+    std::cout << "Could not map file: " << filePath << std::endl;
+    return false;
+  }
+  madvise(data, fileStat.st_size, MADV_SEQUENTIAL);
+  madvise(data, fileStat.st_size, MADV_WILLNEED);
+
+  outMappedFile.data = (const char*)data;
+  outMappedFile.size = fileStat.st_size;
+#endif
+
+  return true;
+}
+
+void unmapFile(MappedFile& mappedFile) {
+  if(mappedFile.data != nullptr) {
+#ifdef _WIN32
+    UnmapViewOfFile(mappedFile.data);
+    CloseHandle(mappedFile.mappingHandle);
+    CloseHandle(mappedFile.fileHandle);
+#else
+    munmap((void*)mappedFile.data, mappedFile.size);
+#endif
+  }
+  mappedFile = {};
+}
+
 void StartTimer(Timer& timer) {
   timer.prev = std::chrono::high_resolution_clock::now();
   timer.delta = 0.0;
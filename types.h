@@ -23,7 +23,9 @@ typedef size_t memory_index;
 #define PiOverTwo32 1.57079632679f
 #define Tau32 6.28318530717958647692f
 #define RadiansPerDegree (Pi32 / 180.0f)
+#define U16_MAX 0xFFFF
 #define U32_MAX ~0u
+#define U64_MAX ~0ull
 
 #define ArrayCount(Array) (sizeof(Array) / sizeof((Array)[0]))
 